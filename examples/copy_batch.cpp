@@ -0,0 +1,87 @@
+// Benchmark of a halo exchange performed as individual coordinator copies,
+// and as one CopyBatch.
+//
+// A 2D field of nx*ny cells is split into blocks of bx*by cells, and each
+// step copies the edge rows of every block into the ghost rows of its
+// neighbours, so that each step issues hundreds of small copies.
+//
+//  ./copy.batch [nx] [ny] [bx] [by] [threads]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include <CopyBatch.hpp>
+#include <Vector.hpp>
+
+using namespace memory;
+
+using value_type = double;
+using size_type  = std::size_t;
+
+using clock_type    = std::chrono::high_resolution_clock;
+using duration_type = std::chrono::duration<double>;
+
+int main(int argc, char** argv) {
+    size_type nx = argc>1 ? std::atoi(argv[1]) : 2048;
+    size_type ny = argc>2 ? std::atoi(argv[2]) : 2048;
+    size_type bx = argc>3 ? std::atoi(argv[3]) : 64;
+    size_type by = argc>4 ? std::atoi(argv[4]) : 64;
+    unsigned  threads = argc>5 ? std::atoi(argv[5]) : 1;
+
+    threading::transfer_settings().num_threads = threads;
+    threading::transfer_settings().parallel_threshold = 1<<16;
+
+    // the field, and a ghost row above and below every block
+    // the top ghost rows of the blocks in a row of blocks are contiguous, as
+    // are the bottom rows, so the copies for a row of blocks can be merged
+    HostVector<value_type> field(nx*ny, 1.);
+    auto nbx = nx/bx;
+    auto nby = ny/by;
+    HostVector<value_type> ghosts(2*nbx*nby*bx, 0.);
+
+    using view = HostView<value_type>;
+    std::vector<std::pair<view, view>> copies;
+    for(auto j=0u; j<nby; ++j) {
+        for(auto i=0u; i<nbx; ++i) {
+            auto block = j*nbx+i;
+            auto top    = (j*by)*nx + i*bx;
+            auto bottom = (j*by+by-1)*nx + i*bx;
+            auto top_ghost    = block*bx;
+            auto bottom_ghost = (nbx*nby+block)*bx;
+            copies.push_back({field(top, top+bx), ghosts(top_ghost, top_ghost+bx)});
+            copies.push_back({field(bottom, bottom+bx), ghosts(bottom_ghost, bottom_ghost+bx)});
+        }
+    }
+
+    CopyBatch<value_type> batch;
+    for(auto& c: copies) {
+        batch.add(c.first, c.second);
+    }
+
+    HostCoordinator<value_type> coordinator;
+    const int num_steps = 100;
+
+    auto start = clock_type::now();
+    for(auto step=0; step<num_steps; ++step) {
+        for(auto& c: copies) {
+            coordinator.copy(c.first, c.second);
+        }
+    }
+    auto individual = duration_type(clock_type::now()-start).count()/num_steps;
+
+    // the first call coalesces the batch
+    coordinator.copy_batch(batch);
+    start = clock_type::now();
+    for(auto step=0; step<num_steps; ++step) {
+        coordinator.copy_batch(batch);
+    }
+    auto batched = duration_type(clock_type::now()-start).count()/num_steps;
+
+    std::cout << copies.size() << " copies of " << bx << " values, "
+              << batch.segments().size() << " segments after coalescing\n"
+              << "  individual " << individual*1e6 << " us per step\n"
+              << "  batched    " << batched*1e6    << " us per step\n";
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Benchmark of staged_copy() against a direct copy, between pairs of
+// memory spaces that can be tested without a GPU.
+//
+//  ./staged.copy [MiB] [chunk KiB] [buffers]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <EmulatedDeviceCoordinator.hpp>
+#include <StagedCopy.hpp>
+#include <Vector.hpp>
+
+using namespace memory;
+
+using value_type = double;
+using size_type  = std::size_t;
+
+using clock_type    = std::chrono::high_resolution_clock;
+using duration_type = std::chrono::duration<double>;
+
+#ifdef WITH_KNL
+template <typename T>
+using fast_vector = HBWVector<T>;
+const std::string fast_name = "hbw";
+#else
+template <typename T>
+using fast_vector = HostVector<T>;
+const std::string fast_name = "aligned";
+#endif
+
+template <typename T>
+using pool_vector = Array<T, HostCoordinator<T, PoolAllocator<T>>>;
+
+// the best time of a few runs of f
+template <typename F>
+double best_time(F&& f) {
+    auto best = 1e30;
+    for(auto i=0; i<5; ++i) {
+        auto start = clock_type::now();
+        f();
+        best = std::min(best, duration_type(clock_type::now()-start).count());
+    }
+    return best;
+}
+
+template <typename From, typename To>
+void run(std::string const& name, From& from, To& to,
+         size_type chunk_bytes, unsigned n_buffers)
+{
+    auto bytes = double(from.size()*sizeof(value_type));
+
+    auto direct = best_time([&] {to(memory::all) = from;});
+    auto staged = best_time([&] {staged_copy(from, to, chunk_bytes, n_buffers);});
+
+    std::cout << name << "\n"
+              << "  direct " << bytes/direct*1e-9 << " GB/s\n"
+              << "  staged " << bytes/staged*1e-9 << " GB/s\n";
+}
+
+int main(int argc, char** argv) {
+    size_type mib     = argc>1 ? std::atoi(argv[1]) : 256;
+    size_type chunk   = (argc>2 ? std::atoi(argv[2]) : 4096)*size_type(1024);
+    unsigned  buffers = argc>3 ? std::atoi(argv[3]) : 2;
+
+    auto n = mib*(1<<20)/sizeof(value_type);
+    std::cout << "copying " << mib << " MiB in chunks of " << chunk/1024
+              << " KiB through " << buffers << " buffers\n\n";
+
+    {
+        MappedVector<value_type> from(n, 1.);
+        fast_vector<value_type> to(n, 0.);
+        run("mapped -> " + fast_name, from, to, chunk, buffers);
+    }
+    {
+        HostVector<value_type> from(n, 1.);
+        pool_vector<value_type> to(n, 0.);
+        run("aligned -> pool", from, to, chunk, buffers);
+    }
+    {
+        // a device on a PCIe 3 x16 bus, where the transfer to the device
+        // overlaps with reading the host memory
+        emulation_settings().bandwidth = 12e9;
+        MappedVector<value_type> from(n, 1.);
+        EmulatedDeviceVector<value_type> to(n);
+        run("mapped -> emulated device (12 GB/s)", from, to, chunk, buffers);
+    }
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Benchmark of passing views by value into small kernels.
+//
+// A stencil is applied to an array by calling a kernel, that can't be
+// inlined, on millions of short sub-ranges. The kernel takes the sub-ranges
+// as HostView arguments, which are a trivially copyable pointer and size,
+// and so are passed in registers. For comparison the same kernel takes a
+// view type that also stores a one byte coordinator, like views did before
+// coordinators were stored as empty bases, which pads the view to three
+// words that are passed on the stack.
+//
+//  ./view.passing [n] [width] [repetitions]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include <Vector.hpp>
+
+using namespace memory;
+
+using value_type = double;
+using size_type  = std::size_t;
+
+using clock_type    = std::chrono::high_resolution_clock;
+using duration_type = std::chrono::duration<double>;
+
+using view = HostView<value_type>;
+
+// a view with a coordinator data member
+struct padded_view {
+    HostCoordinator<value_type> coordinator;
+    value_type* pointer;
+    size_type size;
+};
+
+static_assert(sizeof(view)==2*sizeof(void*), "views should be two words");
+static_assert(sizeof(padded_view)==3*sizeof(void*), "padded views are three words");
+
+__attribute__((noinline))
+value_type kernel(view in, view out) {
+    value_type sum = 0;
+    for(auto i=size_type(0); i<in.size(); ++i) {
+        sum += in.data()[i];
+    }
+    out.data()[0] = sum;
+    return sum;
+}
+
+__attribute__((noinline))
+value_type kernel(padded_view in, padded_view out) {
+    value_type sum = 0;
+    for(auto i=size_type(0); i<in.size; ++i) {
+        sum += in.pointer[i];
+    }
+    out.pointer[0] = sum;
+    return sum;
+}
+
+int main(int argc, char** argv) {
+    size_type n     = argc>1 ? std::atoi(argv[1]) : 1<<22;
+    size_type width = argc>2 ? std::atoi(argv[2]) : 4;
+    int reps        = argc>3 ? std::atoi(argv[3]) : 10;
+
+    HostVector<value_type> in(n+width, 1.);
+    HostVector<value_type> out(n, 0.);
+
+    std::cout << "sizeof(HostView)    " << sizeof(view) << " bytes" << std::endl;
+    std::cout << "sizeof(padded_view) " << sizeof(padded_view) << " bytes" << std::endl;
+    std::cout << n << " calls of width " << width
+              << ", best of " << reps << std::endl;
+
+    auto best_view = 1e30;
+    auto best_padded = 1e30;
+    value_type check = 0;
+    for(auto r=0; r<reps; ++r) {
+        auto start = clock_type::now();
+        for(auto i=size_type(0); i<n; ++i) {
+            check += kernel(in(i, i+width), out(i, i+1));
+        }
+        best_view = std::min(best_view, duration_type(clock_type::now()-start).count());
+
+        start = clock_type::now();
+        for(auto i=size_type(0); i<n; ++i) {
+            check += kernel(padded_view{{}, in.data()+i, width},
+                            padded_view{{}, out.data()+i, 1});
+        }
+        best_padded = std::min(best_padded, duration_type(clock_type::now()-start).count());
+    }
+
+    std::cout << "HostView     " << best_view*1e9/n << " ns/call" << std::endl;
+    std::cout << "padded_view  " << best_padded*1e9/n << " ns/call" << std::endl;
+    std::cout << "check " << check << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ostream>
+#include <vector>
+
+#include <cassert>
+
+#include "definitions.hpp"
+#include "Range.hpp"
+#include "SplitRange.hpp"
+
+namespace memory {
+
+// Splits a range into n chunks, and moves the boundaries between chunks
+// from the time that each chunk took on the previous call, so that every
+// chunk takes the same time. This suits loops that are repeated many times,
+// e.g. time steps, on cores that run at different speeds, e.g. because of
+// turbo limits or other jobs on the node, e.g.
+//
+//  AdaptiveSplitRange split(Range(0, n), num_threads);
+//  for(auto step=0; step<num_steps; ++step) {
+//      #pragma omp parallel
+//      {
+//          auto i = omp_get_thread_num();
+//          split.timed(i, [&](Range r) {...});
+//      }
+//      split.rebalance();
+//  }
+//
+// The speed of each chunk, in elements per second, is estimated from the
+// last time recorded for it, and rebalance() moves each chunk a fraction
+// relaxation of the way to the size that equalises the times, to damp the
+// effect of noise in the timings. Chunks that have never been timed are
+// assumed to run at the mean speed of those that have. Every chunk keeps at
+// least one element while there are at least n elements, so that it can
+// still be timed.
+//
+// rebalance() consumes the times recorded since the previous rebalance(),
+// and keeps them for instrumentation in last_times(): imbalance() is the
+// ratio of the longest time to the mean time.
+class AdaptiveSplitRange {
+  public:
+    using size_type       = Range::size_type;
+    using difference_type = Range::difference_type;
+
+    using iterator = std::vector<Range>::const_iterator;
+
+    // split rng into n balanced chunks
+    AdaptiveSplitRange(Range const& rng, size_type n, double relaxation=0.5)
+    :   range_(rng),
+        relaxation_(relaxation),
+        times_(n, 0.),
+        last_times_(n, 0.),
+        speeds_(n, 0.)
+    {
+        // it makes no sense to break a range into 0 chunks
+        assert(n>0);
+        assert(relaxation>0 && relaxation<=1);
+
+        SplitRange balanced(rng, n, kSplitBalanced);
+        chunks_.assign(balanced.begin(), balanced.end());
+        chunks_.resize(n, Range(rng.right(), rng.right()));
+    }
+
+    iterator begin() const {
+        return chunks_.begin();
+    }
+
+    iterator end() const {
+        return chunks_.end();
+    }
+
+    // the chunk with index i in [0, size())
+    Range operator [] (size_type i) const {
+        assert(i<size());
+        return chunks_[i];
+    }
+
+    Range operator () (size_type i) const {
+        return (*this)[i];
+    }
+
+    // the number of chunks
+    size_type size() const {
+        return chunks_.size();
+    }
+
+    Range range() const {
+        return range_;
+    }
+
+    // record that chunk i took seconds
+    // chunks are recorded by the thread that processed them, so different
+    // chunks can be recorded by different threads at the same time
+    void record(size_type i, double seconds) {
+        assert(i<size());
+        times_[i] = seconds;
+    }
+
+    // call f(r) for chunk r with index i, and record the time it took
+    template <typename F>
+    void timed(size_type i, F&& f) {
+        auto start = std::chrono::steady_clock::now();
+        f((*this)[i]);
+        record(i, std::chrono::duration<double>(
+                      std::chrono::steady_clock::now()-start).count());
+    }
+
+    // move the boundaries between chunks to equalise the recorded times
+    // chunks with no time recorded since the last call keep the speed of the
+    // last estimate, and the recorded times are cleared
+    void rebalance() {
+        auto n = size();
+        for(auto i=size_type(0); i<n; ++i) {
+            if(times_[i]>0 && chunks_[i].size()>0) {
+                speeds_[i] = chunks_[i].size()/times_[i];
+            }
+        }
+        last_times_.swap(times_);
+        std::fill(times_.begin(), times_.end(), 0.);
+
+        // chunks with no estimate run at the mean speed of those with one
+        auto total_speed = 0.;
+        auto num_known = size_type(0);
+        for(auto s: speeds_) {
+            total_speed += s;
+            num_known += s>0;
+        }
+        if(num_known==0) {
+            return;
+        }
+        auto mean_speed = total_speed/num_known;
+        total_speed += (n-num_known)*mean_speed;
+        auto speed = [&](size_type i) {
+            return speeds_[i]>0 ? speeds_[i] : mean_speed;
+        };
+
+        // the size of each chunk that takes the same time at those speeds
+        auto m = double(range_.size());
+        std::vector<double> sizes(n);
+        for(auto i=size_type(0); i<n; ++i) {
+            auto target = m*speed(i)/total_speed;
+            auto current = double(chunks_[i].size());
+            sizes[i] = current + relaxation_*(target-current);
+        }
+
+        // round the cumulative sizes to boundaries, keeping one element in
+        // every chunk while there are enough
+        auto min_size = range_.size()>=n ? size_type(1) : size_type(0);
+        auto first = range_.left();
+        auto sum = 0.;
+        for(auto i=size_type(0); i<n; ++i) {
+            sum += sizes[i];
+            auto last = i+1==n
+                ? range_.right()
+                : range_.left() + size_type(std::llround(std::max(sum, 0.)));
+            last = std::max(last, first+min_size);
+            last = std::min(last, range_.right()-min_size*(n-i-1));
+            chunks_[i] = Range(first, last);
+            first = last;
+        }
+    }
+
+    // the times recorded for each chunk since the last call to rebalance(),
+    // which are zero for chunks that have not been recorded
+    std::vector<double> const& times() const {
+        return times_;
+    }
+
+    // the times used by the last call to rebalance(), which are zero for
+    // chunks that were not recorded
+    std::vector<double> const& last_times() const {
+        return last_times_;
+    }
+
+    // the ratio of the longest recorded time to the mean recorded time, which
+    // is one when the chunks are balanced
+    // this uses the times recorded since the last call to rebalance(), or the
+    // times used by that call if none have been recorded since
+    double imbalance() const {
+        auto recorded = [](double t) {return t>0;};
+        auto const& t = std::any_of(times_.begin(), times_.end(), recorded)
+            ? times_ : last_times_;
+
+        auto longest = *std::max_element(t.begin(), t.end());
+        auto total = 0.;
+        auto count = 0;
+        for(auto x: t) {
+            total += x;
+            count += recorded(x);
+        }
+        return total>0 ? longest*count/total : 1.;
+    }
+
+  private:
+    Range range_;
+    double relaxation_;
+    std::vector<Range> chunks_;
+    std::vector<double> times_;         // recorded since the last rebalance
+    std::vector<double> last_times_;    // used by the last rebalance
+    std::vector<double> speeds_;        // elements per second, or 0 if unknown
+};
+
+// overload output operator for adaptive split range
+inline std::ostream& operator << (std::ostream& os, const AdaptiveSplitRange& split) {
+    os << "(" << split.range() << " in " << split.size()
+       << " adaptive chunks, imbalance " << split.imbalance() << ")";
+    return os;
+}
+
+} // namespace memory
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Allocator.hpp"
+#include "definitions.hpp"
+#include "util.hpp"
+
+// Allocation statistics are recorded by the coordinators when the library is
+// compiled with WITH_MEMORY_STATS (the MEMORY_STATS CMake option). Otherwise
+// the recording calls are compiled out, and the queries below return empty
+// results, so that code that sets tags and prints reports need not change.
+
+namespace memory {
+namespace stats {
+
+using size_type = types::size_type;
+
+constexpr bool enabled() {
+#ifdef WITH_MEMORY_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+// allocation sizes are counted in power of two buckets:
+// bucket b counts allocations of more than 2^(b-1) and at most 2^b bytes
+constexpr unsigned num_buckets = memory::impl::pool::num_size_classes;
+
+struct counters {
+    size_type live_bytes  = 0;
+    size_type peak_bytes  = 0;
+    size_type allocations = 0;
+    size_type frees       = 0;
+    size_type histogram[num_buckets] = {};
+
+    void allocate(size_type bytes) {
+        live_bytes += bytes;
+        if(live_bytes>peak_bytes) {
+            peak_bytes = live_bytes;
+        }
+        ++allocations;
+        ++histogram[memory::impl::pool::size_class(bytes)];
+    }
+
+    void free(size_type bytes) {
+        live_bytes -= bytes;
+        ++frees;
+    }
+};
+
+using report_type = std::vector<std::pair<std::string, counters>>;
+
+namespace impl {
+    // The tag attributed to allocations made by the calling thread.
+    // A null tag means that allocations are untagged.
+    // This has external linkage, so that there is one tag per thread shared
+    // by all translation units.
+    inline const char*& current_tag() {
+        static thread_local const char* tag = nullptr;
+        return tag;
+    }
+
+    class registry {
+    public:
+        // register a memory space, and return its index
+        size_type space(std::string const& name) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            spaces_.push_back({name, counters()});
+            return spaces_.size()-1;
+        }
+
+        void allocate(size_type space, void const* ptr, size_type bytes) {
+            auto tag = current_tag();
+            std::string tag_name(tag ? tag : "untagged");
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            spaces_[space].second.allocate(bytes);
+            tags_[tag_name].allocate(bytes);
+            blocks_[ptr] = block{space, bytes, std::move(tag_name)};
+        }
+
+        void free(void const* ptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = blocks_.find(ptr);
+            // ignore memory allocated before the statistics were reset
+            if(it==blocks_.end()) {
+                return;
+            }
+            auto const& b = it->second;
+            spaces_[b.space].second.free(b.bytes);
+            tags_[b.tag].free(b.bytes);
+            blocks_.erase(it);
+        }
+
+        report_type spaces() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return spaces_;
+        }
+
+        report_type tags() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return report_type(tags_.begin(), tags_.end());
+        }
+
+        void reset() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for(auto& s: spaces_) {
+                s.second = counters();
+            }
+            tags_.clear();
+            blocks_.clear();
+        }
+
+    private:
+        struct block {
+            size_type space;
+            size_type bytes;
+            std::string tag;
+        };
+
+        std::mutex mutex_;
+        report_type spaces_;
+        std::map<std::string, counters> tags_;
+        std::unordered_map<void const*, block> blocks_;
+    };
+
+    // one registry shared by all translation units, which is never
+    // destroyed, so that memory can be freed during program exit
+    inline registry& get_registry() {
+        static auto r = new registry();
+        return *r;
+    }
+
+    // the memory space of an allocator is its policy, so that allocators of
+    // every element type with the same policy share a space, or the type
+    // itself for types that have no policy_type
+    template <typename T>
+    struct void_type {
+        using type = void;
+    };
+
+    template <typename Space, typename = void>
+    struct space_of {
+        using type = Space;
+    };
+
+    template <typename Space>
+    struct space_of<Space, typename void_type<typename Space::policy_type>::type> {
+        using type = typename Space::policy_type;
+    };
+
+    // the index of memory space Space in the registry
+    template <typename Space>
+    size_type space_index() {
+        static const auto index
+            = get_registry().space(util::type_printer<Space>::print());
+        return index;
+    }
+} // namespace impl
+
+// Record an allocation or free in memory space Space.
+// The coordinators pass their allocator as Space, which is recorded in the
+// space named by the allocator's policy.
+// These are called by the coordinators, and should not be called directly.
+template <typename Space>
+void record_allocate(void const* ptr, size_type bytes) {
+    if(ptr) {
+        using space = typename impl::space_of<Space>::type;
+        impl::get_registry().allocate(impl::space_index<space>(), ptr, bytes);
+    }
+}
+
+static inline void record_free(void const* ptr) {
+    if(ptr) {
+        impl::get_registry().free(ptr);
+    }
+}
+
+// Attribute allocations made on the calling thread during the lifetime of
+// the tag to name. Tags can be nested, in which case the innermost tag is
+// used. name must outlive the tag.
+class ScopedTag {
+public:
+    explicit ScopedTag(const char* name)
+    :   previous_(impl::current_tag())
+    {
+        impl::current_tag() = name;
+    }
+
+    ~ScopedTag() {
+        impl::current_tag() = previous_;
+    }
+
+    ScopedTag(ScopedTag const&) = delete;
+    ScopedTag& operator=(ScopedTag const&) = delete;
+
+private:
+    const char* previous_;
+};
+
+// counters for each memory space in which memory has been allocated
+static inline report_type spaces() {
+    return impl::get_registry().spaces();
+}
+
+// counters for each tag
+static inline report_type tags() {
+    return impl::get_registry().tags();
+}
+
+// reset all counters to zero, and forget about live allocations
+static inline void reset() {
+    impl::get_registry().reset();
+}
+
+static inline void print(std::ostream& os, report_type const& report) {
+    for(auto const& entry: report) {
+        auto const& c = entry.second;
+        os << entry.first << "\n"
+           << "  live " << c.live_bytes << " bytes, peak " << c.peak_bytes
+           << " bytes, " << c.allocations << " allocations, "
+           << c.frees << " frees\n";
+        for(auto b=0u; b<num_buckets; ++b) {
+            if(c.histogram[b]) {
+                os << "  <= " << std::setw(12) << (size_type(1)<<b)
+                   << " bytes : " << c.histogram[b] << "\n";
+            }
+        }
+    }
+}
+
+// print the counters for all memory spaces and tags
+static inline void report(std::ostream& os) {
+    if(!enabled()) {
+        os << "memory statistics are disabled: compile with WITH_MEMORY_STATS"
+           << std::endl;
+        return;
+    }
+    os << "== memory spaces ==\n";
+    print(os, spaces());
+    os << "== tags ==\n";
+    print(os, tags());
+    os << std::flush;
+}
+
+} // namespace stats
+} // namespace memory
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <limits>
+#include <map>
+#include <mutex>
+#include <ostream>
+
+#include <sys/mman.h>
 
 #ifdef WITH_CUDA
 #include <cuda.h>
@@ -15,6 +21,24 @@
 
 namespace memory {
 
+// the kind of pages that back a block of host memory
+enum PageBacking {
+    kPageUnknown,           // memory not allocated by a huge page policy
+    kPageSmall,             // default (usually 4 KiB) pages
+    kPageTransparentHuge,   // madvise(MADV_HUGEPAGE) on 2 MiB aligned memory
+    kPageHugeTLB            // mmap with MAP_HUGETLB from the hugetlbfs pool
+};
+
+static inline std::ostream& operator << (std::ostream& os, PageBacking b) {
+    switch(b) {
+        case kPageUnknown         : return os << "unknown";
+        case kPageSmall           : return os << "small pages";
+        case kPageTransparentHuge : return os << "transparent huge pages";
+        case kPageHugeTLB         : return os << "hugetlbfs pages";
+    }
+    return os;
+}
+
 namespace impl {
     using size_type = std::size_t;
 
@@ -95,6 +119,482 @@ namespace impl {
         }
     };
 
+    namespace pool {
+        constexpr unsigned num_size_classes = sizeof(size_type)*8;
+
+        // returns the index of the smallest power of two size class that
+        // can hold n bytes, i.e. the smallest c such that 2^c >= n
+        inline unsigned size_class(size_type n) {
+            unsigned c = 0;
+            while(c<num_size_classes-1 && (size_type(1)<<c)<n) {
+                ++c;
+            }
+            return c;
+        }
+
+        constexpr size_type class_bytes(unsigned c) {
+            return size_type(1)<<c;
+        }
+
+        // Blocks handed out by pooled policies are preceded by a header of
+        // HeaderSize bytes that records the size class of the block, so that
+        // the block can be returned to the right free list without the caller
+        // having to pass its size. HeaderSize is the alignment of the policy,
+        // so that the memory returned to the user keeps that alignment.
+        template <size_type HeaderSize>
+        struct block_header {
+            static_assert(HeaderSize>=sizeof(unsigned),
+                    "block header is too small to hold a size class");
+
+            static unsigned& size_class(void* block) {
+                return *reinterpret_cast<unsigned*>(
+                            reinterpret_cast<char*>(block)-HeaderSize);
+            }
+
+            static void* from_raw(void* raw) {
+                return reinterpret_cast<char*>(raw)+HeaderSize;
+            }
+
+            static void* to_raw(void* block) {
+                return reinterpret_cast<char*>(block)-HeaderSize;
+            }
+        };
+
+        // singly linked free lists of blocks, one list per size class
+        // a free block stores the pointer to the next free block in its
+        // first word
+        class free_lists {
+        public:
+            free_lists() {
+                std::fill(heads_, heads_+num_size_classes, nullptr);
+            }
+
+            // returns nullptr if there is no free block of size class c
+            void* pop(unsigned c) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                void* block = heads_[c];
+                if(block) {
+                    heads_[c] = next(block);
+                    cached_bytes_ -= class_bytes(c);
+                }
+                return block;
+            }
+
+            void push(void* block, unsigned c) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                next(block) = heads_[c];
+                heads_[c] = block;
+                cached_bytes_ += class_bytes(c);
+            }
+
+            // removes every block from the lists, calling f(block) on each
+            template <typename F>
+            void drain(F&& f) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for(auto& head: heads_) {
+                    while(head) {
+                        void* block = head;
+                        head = next(block);
+                        f(block);
+                    }
+                }
+                cached_bytes_ = 0;
+            }
+
+            size_type cached_bytes() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return cached_bytes_;
+            }
+
+        private:
+            static void*& next(void* block) {
+                return *reinterpret_cast<void**>(block);
+            }
+
+            std::mutex mutex_;
+            void* heads_[num_size_classes];
+            size_type cached_bytes_ = 0;
+        };
+    } // namespace pool
+
+    // Allocation policy that recycles freed blocks instead of returning them
+    // to the system. Requests are rounded up to a power of two size class,
+    // and freed blocks are kept on a free list for their size class, so that
+    // repeated allocation and freeing of arrays of similar size only costs a
+    // lock and a pointer swap after the first allocation.
+    //
+    // Requests larger than MaxBlockSize bytes are not pooled, and are freed
+    // immediately. Cached blocks are only returned to the system by release().
+    //
+    // The free lists are shared by all instances of the policy with the same
+    // template parameters.
+    template <size_type Alignment, size_type MaxBlockSize=(size_type(1)<<30)>
+    class PoolPolicy {
+        using header = pool::block_header<Alignment>;
+        static constexpr unsigned unpooled = pool::num_size_classes;
+
+    public:
+        void *allocate_policy(size_type size) {
+            auto c = pool::size_class(size<Alignment ? Alignment : size);
+            if(pool::class_bytes(c)>MaxBlockSize) {
+                return make_block(size, unpooled);
+            }
+
+            if(void* block = free_lists().pop(c)) {
+                return block;
+            }
+
+            return make_block(pool::class_bytes(c), c);
+        }
+
+        void free_policy(void *ptr) {
+            if(ptr == nullptr) {
+                return;
+            }
+
+            auto c = header::size_class(ptr);
+            if(c==unpooled) {
+                free(header::to_raw(ptr));
+            }
+            else {
+                free_lists().push(ptr, c);
+            }
+        }
+
+        // return all cached blocks to the system
+        static void release() {
+            free_lists().drain(
+                [](void* block) {free(header::to_raw(block));});
+        }
+
+        // number of bytes held in free blocks that have not been released
+        static size_type cached_bytes() {
+            return free_lists().cached_bytes();
+        }
+
+        static constexpr size_type alignment() {
+            return Alignment;
+        }
+        static constexpr bool is_malloc_compatible() {
+            return true;
+        }
+
+    private:
+        // The lists are deliberately never destroyed, so that arrays with
+        // static storage duration can still be freed during program exit.
+        static pool::free_lists& free_lists() {
+            static auto lists = new pool::free_lists();
+            return *lists;
+        }
+
+        static void* make_block(size_type bytes, unsigned c) {
+            void* raw = aligned_malloc<char, Alignment>(Alignment+bytes);
+            if(raw == nullptr) {
+                return nullptr;
+            }
+            void* block = header::from_raw(raw);
+            header::size_class(block) = c;
+            return block;
+        }
+    };
+
+    namespace mapped {
+        // Records the length and kind of blocks of memory that have to be
+        // released with the length they were created with (e.g. munmap),
+        // because free_policy() is only passed the pointer.
+        class registry {
+        public:
+            struct record {
+                size_type bytes;
+                int kind;
+            };
+
+            void insert(void* ptr, record r) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                records_[ptr] = r;
+            }
+
+            // returns false if ptr is not in the registry
+            bool find(void const* ptr, record& r) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = records_.find(const_cast<void*>(ptr));
+                if(it==records_.end()) {
+                    return false;
+                }
+                r = it->second;
+                return true;
+            }
+
+            // returns false if ptr is not in the registry
+            bool remove(void* ptr, record& r) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = records_.find(ptr);
+                if(it==records_.end()) {
+                    return false;
+                }
+                r = it->second;
+                records_.erase(it);
+                return true;
+            }
+
+        private:
+            std::mutex mutex_;
+            std::map<void*, record> records_;
+        };
+    } // namespace mapped
+
+    // Allocation policy that backs large blocks with 2 MiB pages, to reduce
+    // TLB misses when streaming over large arrays.
+    //
+    // Blocks of at least one huge page are first requested from the
+    // hugetlbfs pool with mmap(MAP_HUGETLB). If no huge pages are reserved,
+    // the block is allocated on a 2 MiB boundary and the kernel is asked to
+    // back it with transparent huge pages using madvise(MADV_HUGEPAGE).
+    // Smaller blocks are allocated with Alignment like AlignedPolicy.
+    //
+    // backing() reports which kind of pages were actually obtained.
+    template <size_type Alignment>
+    class HugePagePolicy {
+    public:
+        static constexpr size_type huge_page_size = size_type(1)<<21;
+
+        void *allocate_policy(size_type size) {
+            if(size<huge_page_size) {
+                return aligned_malloc<char, Alignment>(size);
+            }
+
+            // round up to a whole number of huge pages
+            auto bytes = (size+huge_page_size-1)/huge_page_size*huge_page_size;
+
+#ifdef MAP_HUGETLB
+            auto flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_2MB
+            flags |= MAP_HUGE_2MB;
+#endif
+            void* huge = mmap(nullptr, bytes, PROT_READ|PROT_WRITE, flags, -1, 0);
+            if(huge != MAP_FAILED) {
+                registry().insert(huge, {bytes, kPageHugeTLB});
+                return huge;
+            }
+#endif
+
+            void* ptr = aligned_malloc<char, huge_page_size>(bytes);
+            if(ptr == nullptr) {
+                return nullptr;
+            }
+
+            auto backing = kPageSmall;
+#ifdef MADV_HUGEPAGE
+            if(madvise(ptr, bytes, MADV_HUGEPAGE)==0) {
+                backing = kPageTransparentHuge;
+            }
+#endif
+            registry().insert(ptr, {bytes, backing});
+            return ptr;
+        }
+
+        void free_policy(void *ptr) {
+            if(ptr == nullptr) {
+                return;
+            }
+
+            mapped::registry::record r;
+            if(registry().remove(ptr, r) && r.kind==kPageHugeTLB) {
+                munmap(ptr, r.bytes);
+            }
+            else {
+                free(ptr);
+            }
+        }
+
+        // returns the kind of pages that back a block allocated by the policy
+        static PageBacking backing(void const* ptr) {
+            if(ptr == nullptr) {
+                return kPageUnknown;
+            }
+            mapped::registry::record r;
+            return registry().find(ptr, r) ? PageBacking(r.kind) : kPageSmall;
+        }
+
+        static constexpr size_type alignment() {
+            return Alignment;
+        }
+        static constexpr bool is_malloc_compatible() {
+            return true;
+        }
+
+    private:
+        static mapped::registry& registry() {
+            static auto r = new mapped::registry();
+            return *r;
+        }
+    };
+
+    // Allocation policy that rounds the size of every block up to a multiple
+    // of Width bytes, and sets the padding bytes at the end of the block to
+    // zero, which is the value initialized state of arithmetic types.
+    // Kernels can then process arrays in whole SIMD vectors of Width bytes,
+    // without remainder loops, by running over the padded size of the array.
+    template <typename Policy, size_type Width=Policy::alignment()>
+    class PaddedPolicy : public Policy {
+        static_assert(is_power_of_two(Width), "padding width is not a power of two");
+    public:
+        void *allocate_policy(size_type size) {
+            auto padded = (size+Width-1)/Width*Width;
+            auto ptr = reinterpret_cast<char*>(Policy::allocate_policy(padded));
+            if(ptr) {
+                std::fill(ptr+size, ptr+padded, char(0));
+            }
+            return ptr;
+        }
+
+        static constexpr size_type padding_width() {
+            return Width;
+        }
+    };
+
+    // returns the width in bytes to which an allocator pads its allocations,
+    // or zero if the allocator does not pad
+    template <typename A>
+    constexpr auto padding_width_impl(int) -> decltype(A::padding_width()) {
+        return A::padding_width();
+    }
+
+    template <typename A>
+    constexpr size_type padding_width_impl(...) {
+        return 0;
+    }
+
+    template <typename A>
+    constexpr size_type padding_width() {
+        return padding_width_impl<A>(0);
+    }
+
+    namespace thread_cache {
+        // Per-thread free lists used by ThreadCachePolicy. This type is
+        // trivially destructible, so that the cache of a thread can still be
+        // inspected after the thread's reaper has run, e.g. when arrays with
+        // static storage are freed at program exit.
+        struct free_lists {
+            void* heads[pool::num_size_classes];
+            size_type cached_bytes;
+            bool closed;
+        };
+
+        static inline void*& next(void* block) {
+            return *reinterpret_cast<void**>(block);
+        }
+    } // namespace thread_cache
+
+    // Allocation policy that puts a per-thread cache in front of another
+    // host policy. Blocks freed on a thread are kept on free lists local to
+    // that thread, and reused by later allocations of the same size class on
+    // the same thread without locking or calling the underlying policy.
+    //
+    // Requests are rounded up to a power of two size class. At most MaxBytes
+    // are cached per thread; blocks that would exceed this, or that are
+    // larger than MaxBytes, are returned to the underlying policy. The cache
+    // of a thread is flushed when the thread exits, or by calling flush().
+    template <typename Policy, size_type MaxBytes=(size_type(1)<<26)>
+    class ThreadCachePolicy {
+        static constexpr size_type header_size = Policy::alignment();
+        using header = pool::block_header<header_size>;
+        static constexpr unsigned uncached = pool::num_size_classes;
+
+    public:
+        void *allocate_policy(size_type size) {
+            auto c = pool::size_class(size<header_size ? header_size : size);
+            if(pool::class_bytes(c)>MaxBytes) {
+                return make_block(size, uncached);
+            }
+
+            auto& lists = cache();
+            if(void* block = lists.heads[c]) {
+                lists.heads[c] = thread_cache::next(block);
+                lists.cached_bytes -= pool::class_bytes(c);
+                return block;
+            }
+
+            return make_block(pool::class_bytes(c), c);
+        }
+
+        void free_policy(void *ptr) {
+            if(ptr == nullptr) {
+                return;
+            }
+
+            auto c = header::size_class(ptr);
+            auto& lists = cache();
+            if(c==uncached || lists.closed
+               || lists.cached_bytes+pool::class_bytes(c)>MaxBytes)
+            {
+                Policy().free_policy(header::to_raw(ptr));
+                return;
+            }
+
+            thread_cache::next(ptr) = lists.heads[c];
+            lists.heads[c] = ptr;
+            lists.cached_bytes += pool::class_bytes(c);
+        }
+
+        // return all blocks cached by the calling thread to the underlying
+        // policy
+        static void flush() {
+            auto& lists = cache();
+            for(auto& head: lists.heads) {
+                while(head) {
+                    void* block = head;
+                    head = thread_cache::next(block);
+                    Policy().free_policy(header::to_raw(block));
+                }
+            }
+            lists.cached_bytes = 0;
+        }
+
+        // number of bytes cached by the calling thread
+        static size_type cached_bytes() {
+            return cache().cached_bytes;
+        }
+
+        static constexpr size_type alignment() {
+            return Policy::alignment();
+        }
+        static constexpr bool is_malloc_compatible() {
+            return Policy::is_malloc_compatible();
+        }
+
+    private:
+        // flushes the cache of a thread when the thread exits, and closes it
+        // so that blocks freed afterwards go straight to the policy
+        struct reaper {
+            ~reaper() {
+                flush();
+                cache_lists().closed = true;
+            }
+        };
+
+        static thread_cache::free_lists& cache_lists() {
+            static thread_local thread_cache::free_lists lists;
+            return lists;
+        }
+
+        static thread_cache::free_lists& cache() {
+            static thread_local reaper r;
+            (void)r;
+            return cache_lists();
+        }
+
+        static void* make_block(size_type bytes, unsigned c) {
+            void* raw = Policy().allocate_policy(header_size+bytes);
+            if(raw == nullptr) {
+                return nullptr;
+            }
+            void* block = header::from_raw(raw);
+            header::size_class(block) = c;
+            return block;
+        }
+    };
+
 #ifdef WITH_KNL
     namespace knl {
         // allocate memory with alignment specified as a template parameter
@@ -227,6 +727,7 @@ class Allocator : public Policy {
 public:
     using Policy::alignment;
 
+    using policy_type   = Policy;
     using value_type    = T;
     using pointer       = value_type*;
     using const_pointer = const value_type*;
@@ -241,8 +742,18 @@ public:
 
 public:
     inline explicit Allocator() {}
-    inline ~Allocator() {}
-    inline explicit Allocator(Allocator const&) {}
+    inline ~Allocator() = default;
+    inline Allocator(Allocator const&) = default;
+
+    // construct with an instance of the policy, for policies with state,
+    // e.g. the arena or heap from which memory is allocated
+    inline explicit Allocator(Policy const& policy) : Policy(policy) {}
+
+    // construct from an allocator for another type with the same policy
+    template <typename U>
+    inline Allocator(Allocator<U, Policy> const& other)
+    :   Policy(static_cast<Policy const&>(other))
+    {}
 
     inline pointer address(reference r) {
         return &r;
@@ -291,6 +802,44 @@ namespace util {
         }
     };
 
+    template <size_t Alignment, size_t MaxBlockSize>
+    struct type_printer<impl::PoolPolicy<Alignment, MaxBlockSize>>{
+        static std::string print() {
+            std::stringstream str;
+            str << "PoolPolicy<" << Alignment << ", " << MaxBlockSize << ">";
+            return str.str();
+        }
+    };
+
+    template <size_t Alignment>
+    struct type_printer<impl::HugePagePolicy<Alignment>>{
+        static std::string print() {
+            std::stringstream str;
+            str << "HugePagePolicy<" << Alignment << ">";
+            return str.str();
+        }
+    };
+
+    template <typename Policy, size_t MaxBytes>
+    struct type_printer<impl::ThreadCachePolicy<Policy, MaxBytes>>{
+        static std::string print() {
+            std::stringstream str;
+            str << "ThreadCachePolicy<" << type_printer<Policy>::print()
+                << ", " << MaxBytes << ">";
+            return str.str();
+        }
+    };
+
+    template <typename Policy, size_t Width>
+    struct type_printer<impl::PaddedPolicy<Policy, Width>>{
+        static std::string print() {
+            std::stringstream str;
+            str << "PaddedPolicy<" << type_printer<Policy>::print()
+                << ", " << Width << ">";
+            return str.str();
+        }
+    };
+
     #ifdef WITH_CUDA
     template <size_t Alignment>
     struct type_printer<impl::cuda::PinnedPolicy<Alignment>>{
@@ -324,10 +873,34 @@ namespace util {
 template <class T, size_t alignment=impl::minimum_possible_alignment<T>()>
 using AlignedAllocator = Allocator<T, impl::AlignedPolicy<alignment>>;
 
+// helper for generating an aligned allocator that recycles freed blocks
+template <class T, size_t alignment=impl::minimum_possible_alignment<T>()>
+using PoolAllocator = Allocator<T, impl::PoolPolicy<alignment>>;
+
+// helper for generating an allocator that backs large arrays with huge pages
+// the default alignment is that of a cache line, which small arrays keep
+template <class T, size_t alignment=64>
+using HugePageAllocator = Allocator<T, impl::HugePagePolicy<alignment>>;
+
+// helper for generating an aligned allocator that pads allocations to a
+// multiple of the alignment, which defaults to the 512 bit SIMD width
+template <class T, size_t alignment=(512/8)>
+using PaddedAllocator =
+    Allocator<T, impl::PaddedPolicy<impl::AlignedPolicy<alignment>>>;
+
+// helper for generating an aligned allocator with a per-thread block cache
+template <class T, size_t alignment=impl::minimum_possible_alignment<T>()>
+using ThreadCachedAllocator =
+    Allocator<T, impl::ThreadCachePolicy<impl::AlignedPolicy<alignment>>>;
+
 #ifdef WITH_KNL
 // align with 512 bit vector register size
 template <class T, size_t alignment=(512/8)>
 using HBWAllocator = Allocator<T, impl::knl::HBWPolicy<alignment>>;
+
+template <class T, size_t alignment=(512/8)>
+using ThreadCachedHBWAllocator =
+    Allocator<T, impl::ThreadCachePolicy<impl::knl::HBWPolicy<alignment>>>;
 #endif
 
 #ifdef WITH_CUDA
@@ -9,10 +9,14 @@
 
 #include <iostream>
 #include <type_traits>
+#include <utility>
 
+#include "Allocator.hpp"
 #include "definitions.hpp"
 #include "util.hpp"
 #include "ArrayView.hpp"
+#include "SplitRange.hpp"
+#include "Threading.hpp"
 
 ////////////////////////////////////////////////////////////////////////////////
 namespace memory{
@@ -73,6 +77,19 @@ namespace impl {
 
 using impl::is_array;
 
+// tag for constructing an Array without initializing its memory
+struct uninitialized_type {};
+
+// tag for constructing an Array with its memory initialized in parallel
+struct parallel_fill_type {};
+
+namespace{
+    // attach the unused attribute so that -Wall won't generate warnings when
+    // translation units that include this file don't use these variables
+    uninitialized_type uninitialized [[gnu::unused]];
+    parallel_fill_type parallel_fill [[gnu::unused]];
+}
+
 // array by value
 // this wrapper owns the memory in the array
 // and is responsible for allocating and freeing memory
@@ -100,67 +117,156 @@ public:
     // we have to call constructor in ArrayView: pass base
     Array() : base(nullptr, 0) {}
 
+    // The constructors that allocate memory take an optional coordinator,
+    // which is used to allocate and free the memory of the array, so that
+    // arrays can be allocated from memory resources with state, e.g.
+    //
+    //  ScratchArena arena(1<<20);
+    //  using arena_coord = HostCoordinator<double, ArenaAllocator<double>>;
+    //  arena_coord coord{ArenaAllocator<double>(arena)};
+    //  Array<double, arena_coord> a(n, coord);
+    //
+    // The coordinator is copied by the copy constructor, and moves with the
+    // memory on move construction and move assignment. Copy assignment keeps
+    // the coordinator of the array that is assigned to. The coordinator is
+    // held by the ArrayView base, so an Array with a stateless coordinator is
+    // the same size as a view.
+
+    // construct an empty array with a coordinator
+    explicit Array(coordinator_type const& coordinator)
+        : base(nullptr, 0, coordinator)
+    {}
+
     // constructor by size
+    // the memory is not initialized: this is equivalent to Array(n, uninitialized)
     template < typename I,
                typename = typename std::enable_if<std::is_integral<I>::value>::type>
-    Array(I n)
-        : base(coordinator_type().allocate(n))
+    Array(I n, coordinator_type const& coordinator=coordinator_type())
+        : base(nullptr, 0, coordinator)
     {
+        allocate(n);
         #ifdef VERBOSE
         std::cerr << util::green("Array(integral_type) ")
                   << util::pretty_printer<Array>::print(*this) << std::endl;
         #endif
     }
 
+    // constructor by size that is guaranteed to leave the memory uninitialized
+    // pages are not touched, so they are placed by the first thread to write them
+    template < typename I,
+               typename = typename std::enable_if<std::is_integral<I>::value>::type>
+    Array(I n, uninitialized_type,
+          coordinator_type const& coordinator=coordinator_type())
+        : base(nullptr, 0, coordinator)
+    {
+        allocate(n);
+        #ifdef VERBOSE
+        std::cerr << util::green("Array(integral_type, uninitialized) ")
+                  << util::pretty_printer<Array>::print(*this) << std::endl;
+        #endif
+    }
+
     // constructor by size with default value
     template < typename II,
                typename TT,
                typename = typename std::enable_if<std::is_integral<II>::value>::type,
                typename = typename std::enable_if<std::is_convertible<TT,value_type>::value>::type >
-    Array(II n, TT value)
-        : base(coordinator_type().allocate(n))
+    Array(II n, TT value, coordinator_type const& coordinator=coordinator_type())
+        : base(nullptr, 0, coordinator)
     {
+        allocate(n);
         #ifdef VERBOSE
         std::cerr << util::green("Array(integral_type, value=" + std::to_string(value) + ") ")
                   << util::pretty_printer<Array>::print(*this) << std::endl;
         #endif
-        coordinator_type().set(*this, value_type(value));
+        base::get_coordinator().set(*this, value_type(value));
+    }
+
+    // constructor by size with default value, where the chunks of split are
+    // initialized by threads bound to cores, see threading::first_touch()
+    // Under a first-touch page placement policy this places the pages of
+    // each chunk close to the core that touched them, so split should be
+    // the partition used by the loops that will later process the array, and
+    // must cover [0, n).
+    template < typename II,
+               typename TT,
+               typename = typename std::enable_if<std::is_integral<II>::value>::type,
+               typename = typename std::enable_if<std::is_convertible<TT,value_type>::value>::type >
+    Array(II n, TT value, SplitRange const& split,
+          coordinator_type const& coordinator=coordinator_type())
+        : base(nullptr, 0, coordinator)
+    {
+        allocate(n);
+        #ifdef VERBOSE
+        std::cerr << util::green("Array(integral_type, value=" + std::to_string(value) + ", split) ")
+                  << util::pretty_printer<Array>::print(*this) << std::endl;
+        #endif
+        base::get_coordinator().set(*this, value_type(value), split);
     }
 
+    // constructor by size with default value, filled in parallel by
+    // num_chunks threads, which defaults to the number of hardware threads
+    template < typename II,
+               typename TT,
+               typename = typename std::enable_if<std::is_integral<II>::value>::type,
+               typename = typename std::enable_if<std::is_convertible<TT,value_type>::value>::type >
+    Array(II n, TT value, parallel_fill_type,
+          size_type num_chunks=threading::hardware_threads(),
+          coordinator_type const& coordinator=coordinator_type())
+        : Array(n, value, SplitRange(Range(0, n), num_chunks), coordinator)
+    {}
+
+    // constructor by size with first-touch initialization to value_type()
+    template < typename I,
+               typename = typename std::enable_if<std::is_integral<I>::value>::type>
+    Array(I n, SplitRange const& split,
+          coordinator_type const& coordinator=coordinator_type())
+        : Array(n, value_type(), split, coordinator)
+    {}
+
+    // construct as a copy of another array or view
+    // copies of Array, const or not, use the copy constructor, which also
+    // copies the coordinator
     template <typename Other,
               typename = typename
                   std::enable_if<
-                                 impl::is_array_t<Other>::value
+                                 impl::is_array_t<Other>::value &&
+                                 !std::is_same<typename std::decay<Other>::type, Array>::value
                                 >::type
              >
     Array(Other&& other)
-        : base(coordinator_type().allocate(other.size()))
+        : base(nullptr, 0)
     {
-        coordinator_.copy(other, *this);
+        allocate(other.size());
+        base::get_coordinator().copy(other, *this);
     }
 
     // construct as a copy of another range
     Array(view_type const& other)
-        : base(coordinator_type().allocate(other.size()))
+        : base(nullptr, 0)
     {
+        allocate(other.size());
 #ifdef VERBOSE
         std::cerr << util::green("Array(other&)") + " other = "
                   << util::pretty_printer<view_type>::print(other) << std::endl;
 #endif
-        coordinator_.copy(static_cast<base const&>(other), *this);
+        base::get_coordinator().copy(static_cast<base const&>(other), *this);
     }
 
     Array(const Array& other)
-        : base(coordinator_type().allocate(other.size()))
+        : base(nullptr, 0, other.coordinator())
     {
+        allocate(other.size());
 #ifdef VERBOSE
         std::cerr << util::green("Array(other&)") + " other = "
                   << util::pretty_printer<Array>::print(other) << std::endl;
 #endif
-        coordinator_.copy(static_cast<base const&>(other), *this);
+        base::get_coordinator().copy(static_cast<base const&>(other), *this);
     }
 
-    Array(Array&& other) {
+    Array(Array&& other)
+        : base(nullptr, 0, other.coordinator())
+    {
 #ifdef VERBOSE
         std::cerr << util::green("Array(Array&&) ")
                   << util::pretty_printer<Array>::print(other) << std::endl;
@@ -173,9 +279,10 @@ public:
     /// used to copy from the vector into the Array does not convert between types
     template < typename Allocator >
     Array(std::vector<value_type, Allocator> const& other)
-    : base(coordinator_type().allocate(other.size()))
+    : base(nullptr, 0)
     {
-        coordinator_.copy(
+        allocate(other.size());
+        base::get_coordinator().copy(
             const_view_type(other.data(), other.size()),
             *this
         );
@@ -186,10 +293,9 @@ public:
         std::cerr << util::green("Array operator=(other&)") + " other = "
                   << util::pretty_printer<Array>::print(other) << std::endl;
 #endif
-        coordinator_.free(*this);
-        auto ptr = coordinator_type().allocate(other.size());
-        base::reset(ptr.data(), other.size());
-        coordinator_.copy(static_cast<base const&>(other), *this);
+        base::get_coordinator().free(*this);
+        allocate(other.size());
+        base::get_coordinator().copy(static_cast<base const&>(other), *this);
         return *this;
     }
 
@@ -200,6 +306,7 @@ public:
                   << util::pretty_printer<Array>::print(other) << std::endl;
 #endif
         base::swap(other);
+        std::swap(base::get_coordinator(), other.get_coordinator());
         return *this;
     }
 
@@ -209,7 +316,7 @@ public:
         std::cerr << util::red("~") + util::green("Array()") + " "
                   << util::pretty_printer<Array>::print(*this) << std::endl;
 #endif
-        coordinator_.free(*this);
+        base::get_coordinator().free(*this);
     }
 
     // use the accessors provided by ArrayView
@@ -218,15 +325,39 @@ public:
     using base::operator();
 
     const coordinator_type& coordinator() const {
-        return coordinator_;
+        return base::get_coordinator();
     }
 
     using base::size;
 
     using base::alignment;
 
+    // the number of elements including the padding added by a padded
+    // allocator, which is the same as size() for allocators that don't pad
+    size_type padded_size() const {
+        return padded_size_impl(coordinator_type::padding());
+    }
+
+    // view of the array including padding
+    view_type padded_view() {
+        return view_type(base::data(), padded_size());
+    }
+
+    const_view_type padded_view() const {
+        return const_view_type(base::data(), padded_size());
+    }
+
 private:
-    coordinator_type coordinator_;
+    // allocate n elements with the coordinator of the array
+    void allocate(size_type n) {
+        auto storage = base::get_coordinator().allocate(n);
+        base::reset(storage.data(), storage.size());
+    }
+
+    size_type padded_size_impl(size_type width) const {
+        return width ? size()+impl::get_padding<value_type>(width, size())
+                     : size();
+    }
 };
 
 } // namespace memory
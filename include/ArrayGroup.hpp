@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+
+#include "definitions.hpp"
+#include "HostCoordinator.hpp"
+
+namespace memory {
+
+// A group of arrays of the same length that are allocated together with
+// HostCoordinator::allocate_group(), so that each array starts at a
+// different offset within a page. The group owns the memory, which is freed
+// when the group is destroyed, and the arrays are accessed through views.
+//
+// For example, the arrays of a STREAM triad can be allocated as
+//  ArrayGroup<double> arrays(n, 3);
+//  auto& a = arrays[0]; auto& b = arrays[1]; auto& c = arrays[2];
+//
+// As for Array, the group allocates and frees with a coordinator, which is
+// held in an impl::ebo_storage base so that a stateless coordinator takes no
+// space, and moves with the memory.
+template <typename T, typename Coord=HostCoordinator<T>>
+class ArrayGroup
+    : private impl::ebo_storage<
+        typename Coord::template rebind<T>, ArrayGroup<T, Coord>>
+{
+    using coordinator_storage = impl::ebo_storage<
+        typename Coord::template rebind<T>, ArrayGroup<T, Coord>>;
+public:
+    using value_type       = T;
+    using coordinator_type = typename Coord::template rebind<value_type>;
+    using view_type        = typename coordinator_type::view_type;
+    using size_type        = types::size_type;
+
+    ArrayGroup(size_type n, size_type count, size_type colour_bytes=64,
+               coordinator_type const& coordinator=coordinator_type())
+    :   coordinator_storage(coordinator),
+        views_(coordinator_storage::get().allocate_group(n, count, colour_bytes))
+    {}
+
+    ArrayGroup(ArrayGroup&& other)
+    :   coordinator_storage(other.coordinator()),
+        views_(std::move(other.views_))
+    {
+        other.views_.clear();
+    }
+
+    ArrayGroup(ArrayGroup const&) = delete;
+    ArrayGroup& operator=(ArrayGroup const&) = delete;
+
+    ~ArrayGroup() {
+        coordinator_storage::get().free_group(views_);
+    }
+
+    const coordinator_type& coordinator() const {
+        return coordinator_storage::get();
+    }
+
+    // the number of arrays in the group
+    size_type size() const {
+        return views_.size();
+    }
+
+    view_type& operator[](size_type i) {
+        return views_[i];
+    }
+
+    view_type const& operator[](size_type i) const {
+        return views_[i];
+    }
+
+private:
+    std::vector<view_type> views_;
+};
+
+} // namespace memory
@@ -191,8 +191,16 @@ namespace impl {
 // Currently the ArrayRange type has no way of testing whether the memory to
 // which it refers is still valid (i.e. whether or not the original memory has
 // been freed)
+// The coordinator is held in an impl::ebo_storage base, so that a view with a
+// stateless coordinator is just a pointer and a size, which is passed to and
+// returned from functions in registers.
 template <typename R, typename T, typename Coord>
-class ArrayViewImpl {
+class ArrayViewImpl
+    : protected impl::ebo_storage<
+        typename Coord::template rebind<T>, ArrayViewImpl<R, T, Coord>>
+{
+    using coordinator_storage = impl::ebo_storage<
+        typename Coord::template rebind<T>, ArrayViewImpl<R, T, Coord>>;
 public:
     using array_reference_type       = ArrayReference<T, Coord>;
     using const_array_reference_type = ConstArrayReference<T, Coord>;
@@ -236,6 +244,13 @@ public:
 #endif
     }
 
+    // with a coordinator that has state, e.g. a stateful allocator
+    explicit ArrayViewImpl(pointer ptr, size_type n, coordinator_type const& coordinator)
+    :   coordinator_storage(coordinator)
+    ,   pointer_(ptr)
+    ,   size_(n)
+    {}
+
     // only works with non const vector until we have a const_view type available
     template <
         typename Allocator,
@@ -375,18 +390,19 @@ public:
         #ifndef NDEBUG
         assert(i<size_);
         #endif
-        return coordinator_.make_reference(pointer_+i);
+        return get_coordinator().make_reference(pointer_+i);
     }
 
     const_reference operator[] (size_type i) const {
         #ifndef NDEBUG
         assert(i<size_);
         #endif
-        return coordinator_.make_reference(pointer_+i);
+        return get_coordinator().make_reference(pointer_+i);
     }
 
     // do nothing for destructor: we don't own the memory in range
-    ~ArrayViewImpl() {}
+    // the destructor is trivial, so that views are passed in registers
+    ~ArrayViewImpl() = default;
 
     // test whether memory overlaps that referenced by other
     template <
@@ -433,13 +449,26 @@ protected :
     // disallow constructors that imply allocation of memory
     ArrayViewImpl(const std::size_t &n) = delete;
 
-    coordinator_type coordinator_;
+    coordinator_type& get_coordinator() {
+        return coordinator_storage::get();
+    }
+
+    coordinator_type const& get_coordinator() const {
+        return coordinator_storage::get();
+    }
+
     pointer          pointer_;
     size_type        size_;
 };
 
+// The coordinator is held in an impl::ebo_storage base, as in ArrayViewImpl.
 template <typename R, typename T, typename Coord>
-class ConstArrayViewImpl {
+class ConstArrayViewImpl
+    : protected impl::ebo_storage<
+        typename Coord::template rebind<T>, ConstArrayViewImpl<R, T, Coord>>
+{
+    using coordinator_storage = impl::ebo_storage<
+        typename Coord::template rebind<T>, ConstArrayViewImpl<R, T, Coord>>;
 public:
     using const_array_reference_type = ConstArrayView<T, Coord>;
 
@@ -566,11 +595,12 @@ public:
         #ifndef NDEBUG
         assert(i<size_);
         #endif
-        return coordinator_.make_reference(pointer_+i);
+        return get_coordinator().make_reference(pointer_+i);
     }
 
     // do nothing for destructor: we don't own the memory in range
-    ~ConstArrayViewImpl() {}
+    // the destructor is trivial, so that views are passed in registers
+    ~ConstArrayViewImpl() = default;
 
     // test whether memory overlaps that referenced by other
     template <
@@ -617,7 +647,10 @@ protected :
         size_ = n;
     }
 
-    coordinator_type coordinator_;
+    coordinator_type const& get_coordinator() const {
+        return coordinator_storage::get();
+    }
+
     const_pointer    pointer_;
     size_type        size_;
 };
@@ -635,7 +668,6 @@ public:
     using pointer         = typename base::pointer;
     using reference       = typename base::reference;
 
-    using base::coordinator_;
     using base::pointer_;
     using base::size_;
     using base::size;
@@ -670,7 +702,7 @@ public:
                   << util::type_printer<typename std::decay<Other>::type>::print()
                   << ")" << std::endl;
 #endif
-        base::coordinator_.copy(other, *this);
+        base::get_coordinator().copy(other, *this);
 
         return *this;
     }
@@ -682,7 +714,7 @@ public:
                   << std::endl;
 #endif
         if(size()>0) {
-            base::coordinator_.set(*this, value);
+            base::get_coordinator().set(*this, value);
         }
 
         return *this;
@@ -709,7 +741,6 @@ public:
     using const_pointer   = typename base::const_pointer;
     using const_reference = typename base::const_reference;
 
-    using base::coordinator_;
     using base::pointer_;
     using base::size_;
     using base::size;
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "definitions.hpp"
+
+// Size-tiered implementations of copy and fill for host memory, used by
+// HostCoordinator.
+//
+//  - types that are not trivially copyable are copied element by element
+//  - trivially copyable types are copied with memcpy, and filled with memset
+//    when every byte of the fill value is the same
+//  - transfers larger than settings().nontemporal_threshold bytes, which
+//    should be much larger than the last level cache, use non-temporal
+//    (streaming) stores that bypass the cache, to avoid polluting it and
+//    the read-for-ownership traffic of normal stores
+//
+// Non-temporal stores are implemented with SSE2/AVX intrinsics, so they are
+// available with any compiler targeting x86-64. On other targets the
+// non-temporal tier falls back to memcpy/memset.
+
+namespace memory {
+namespace bulk {
+
+using size_type = types::size_type;
+
+enum Strategy {
+    kBulkElementwise,   // std::copy or std::fill
+    kBulkMemory,        // memcpy or memset
+    kBulkPattern,       // fill a trivially copyable value with a non-uniform byte pattern
+    kBulkNonTemporal    // streaming stores
+};
+
+// returns the size of the last level cache in bytes, or zero if unknown
+static inline size_type last_level_cache_bytes() {
+    long bytes = 0;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    bytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if(bytes<=0) {
+        bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    }
+#endif
+    return bytes>0 ? size_type(bytes) : 0;
+}
+
+constexpr bool have_nontemporal_stores() {
+#if defined(__SSE2__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+struct Settings {
+    // transfers of at least this many bytes use non-temporal stores
+    // the default is four times the last level cache, or 64 MiB if unknown
+    size_type nontemporal_threshold =
+        last_level_cache_bytes() ? 4*last_level_cache_bytes()
+                                 : size_type(1)<<26;
+};
+
+// the settings shared by all translation units
+inline Settings& settings() {
+    static Settings s;
+    return s;
+}
+
+namespace impl {
+#if defined(__AVX__)
+    using vector_type = __m256i;
+    constexpr size_type vector_bytes = 32;
+    static inline vector_type loadu(void const* p) {
+        return _mm256_loadu_si256(reinterpret_cast<vector_type const*>(p));
+    }
+    static inline void stream(void* p, vector_type v) {
+        _mm256_stream_si256(reinterpret_cast<vector_type*>(p), v);
+    }
+#elif defined(__SSE2__)
+    using vector_type = __m128i;
+    constexpr size_type vector_bytes = 16;
+    static inline vector_type loadu(void const* p) {
+        return _mm_loadu_si128(reinterpret_cast<vector_type const*>(p));
+    }
+    static inline void stream(void* p, vector_type v) {
+        _mm_stream_si128(reinterpret_cast<vector_type*>(p), v);
+    }
+#else
+    constexpr size_type vector_bytes = 1;
+#endif
+
+    // number of bytes from p to the next vector boundary
+    static inline size_type head_bytes(void const* p) {
+        auto misalignment = reinterpret_cast<std::uintptr_t>(p)%vector_bytes;
+        return misalignment ? vector_bytes-misalignment : 0;
+    }
+
+    // copy bytes with non-temporal stores to the vector aligned part of to
+    static inline void stream_copy(void* to, void const* from, size_type bytes) {
+#if defined(__SSE2__)
+        auto dst = reinterpret_cast<char*>(to);
+        auto src = reinterpret_cast<char const*>(from);
+
+        auto head = std::min(head_bytes(dst), bytes);
+        std::memcpy(dst, src, head);
+        dst += head; src += head; bytes -= head;
+
+        auto body = bytes/vector_bytes*vector_bytes;
+        for(size_type i=0; i<body; i+=vector_bytes) {
+            stream(dst+i, loadu(src+i));
+        }
+        _mm_sfence();
+
+        std::memcpy(dst+body, src+body, bytes-body);
+#else
+        std::memcpy(to, from, bytes);
+#endif
+    }
+
+    // fill n copies of value with non-temporal stores, where the size of T
+    // divides the vector width and ptr is aligned to sizeof(T)
+    template <typename T>
+    void stream_fill(T* ptr, size_type n, T value) {
+#if defined(__SSE2__)
+        static_assert(vector_bytes%sizeof(T)==0,
+                "value type does not divide the vector width");
+
+        auto head = std::min(head_bytes(ptr)/sizeof(T), n);
+        std::fill(ptr, ptr+head, value);
+        ptr += head; n -= head;
+
+        // a vector with the byte pattern of value repeated
+        T pattern[vector_bytes/sizeof(T)];
+        std::fill(pattern, pattern+vector_bytes/sizeof(T), value);
+        auto v = loadu(pattern);
+
+        auto dst = reinterpret_cast<char*>(ptr);
+        auto body = n*sizeof(T)/vector_bytes*vector_bytes;
+        for(size_type i=0; i<body; i+=vector_bytes) {
+            stream(dst+i, v);
+        }
+        _mm_sfence();
+
+        auto done = body/sizeof(T);
+        std::fill(ptr+done, ptr+n, value);
+#else
+        std::fill(ptr, ptr+n, value);
+#endif
+    }
+
+    // returns true if every byte of value is the same
+    template <typename T>
+    bool is_uniform(T const& value) {
+        auto bytes = reinterpret_cast<unsigned char const*>(&value);
+        return std::all_of(bytes, bytes+sizeof(T),
+                           [bytes](unsigned char b) {return b==bytes[0];});
+    }
+
+    template <typename T>
+    constexpr bool can_stream_pattern() {
+        return std::is_trivially_copyable<T>::value
+            && vector_bytes%sizeof(T)==0;
+    }
+} // namespace impl
+
+static inline bool use_nontemporal(size_type bytes) {
+    return have_nontemporal_stores() && bytes>=settings().nontemporal_threshold;
+}
+
+// the strategy used to copy n values of type T
+template <typename T>
+Strategy copy_strategy(size_type n) {
+    if(!std::is_trivially_copyable<T>::value) {
+        return kBulkElementwise;
+    }
+    return use_nontemporal(n*sizeof(T)) ? kBulkNonTemporal : kBulkMemory;
+}
+
+// the strategy used to fill n values of type T with value
+template <typename T>
+Strategy fill_strategy(size_type n, T const& value) {
+    if(!std::is_trivially_copyable<T>::value) {
+        return kBulkElementwise;
+    }
+    if(use_nontemporal(n*sizeof(T)) && impl::can_stream_pattern<T>()) {
+        return kBulkNonTemporal;
+    }
+    return impl::is_uniform(value) ? kBulkMemory : kBulkPattern;
+}
+
+// copy n values from from to to using strategy s, which is normally chosen
+// for the whole transfer when it is split into chunks
+template <typename T>
+void copy(T const* from, size_type n, T* to, Strategy s) {
+    switch(s) {
+        case kBulkNonTemporal:
+            impl::stream_copy(to, from, n*sizeof(T));
+            return;
+        case kBulkMemory:
+        case kBulkPattern:
+            std::memcpy(to, from, n*sizeof(T));
+            return;
+        case kBulkElementwise:
+            std::copy(from, from+n, to);
+            return;
+    }
+}
+
+template <typename T>
+void copy(T const* from, size_type n, T* to) {
+    copy(from, n, to, copy_strategy<T>(n));
+}
+
+// fill n values at ptr with value using strategy s
+template <typename T>
+typename std::enable_if<impl::can_stream_pattern<T>()>::type
+fill(T* ptr, size_type n, T value, Strategy s) {
+    if(s==kBulkNonTemporal
+       && reinterpret_cast<std::uintptr_t>(ptr)%sizeof(T)==0) {
+        impl::stream_fill(ptr, n, value);
+    }
+    else if(s==kBulkMemory) {
+        std::memset(ptr, *reinterpret_cast<unsigned char*>(&value), n*sizeof(T));
+    }
+    else {
+        std::fill(ptr, ptr+n, value);
+    }
+}
+
+template <typename T>
+typename std::enable_if<!impl::can_stream_pattern<T>()>::type
+fill(T* ptr, size_type n, T value, Strategy s) {
+    if(s==kBulkMemory) {
+        std::memset(ptr, *reinterpret_cast<unsigned char*>(&value), n*sizeof(T));
+    }
+    else {
+        std::fill(ptr, ptr+n, value);
+    }
+}
+
+template <typename T>
+void fill(T* ptr, size_type n, T value) {
+    fill(ptr, n, value, fill_strategy(n, value));
+}
+
+} // namespace bulk
+} // namespace memory
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "BulkMemory.hpp"
+#include "definitions.hpp"
+#include "SplitRange.hpp"
+#include "Threading.hpp"
+
+// Calibration of the thresholds used by HostCoordinator::copy and
+// HostCoordinator::set, which depend on the cache sizes, memory bandwidth and
+// number of cores of the host.
+//
+// Calibration measures memcpy against non-temporal store bandwidth, and
+// serial against multithreaded copies, over a range of sizes, and picks the
+// crossover points. It takes a few seconds, so the result is cached on disk
+// keyed by the CPU model, so that nodes of different types that share a home
+// directory keep separate results. The cache file is
+//
+//  $MEMORY_CALIBRATION_FILE, if set, or
+//  $HOME/.cache/memory-calibration-<key>.txt
+//
+// Calibration is only run on demand:
+//
+//  memory::calibration::calibrate(); // load or measure, then apply
+//
+// Note that on KNL (WITH_KNL) calibration measures the default host memory,
+// i.e. DDR in flat mode, or MCDRAM backed memory in cache mode.
+
+namespace memory {
+namespace calibration {
+
+using size_type = types::size_type;
+
+// a threshold that is never reached
+constexpr size_type never = std::numeric_limits<size_type>::max();
+
+struct Result {
+    size_type nontemporal_threshold = never;
+    size_type parallel_threshold = never;
+    unsigned num_threads = 1;
+};
+
+static inline std::ostream& operator<<(std::ostream& o, Result const& r) {
+    return o << "nontemporal_threshold " << r.nontemporal_threshold << "\n"
+             << "parallel_threshold "    << r.parallel_threshold    << "\n"
+             << "num_threads "           << r.num_threads           << "\n";
+}
+
+// the model name of the CPU, or "unknown"
+static inline std::string cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while(std::getline(cpuinfo, line)) {
+        if(line.compare(0, 10, "model name")==0) {
+            auto pos = line.find(':');
+            if(pos!=std::string::npos) {
+                auto first = line.find_first_not_of(" \t", pos+1);
+                return first==std::string::npos ? "unknown" : line.substr(first);
+            }
+        }
+    }
+    return "unknown";
+}
+
+namespace impl {
+    // FNV-1a, which unlike std::hash is the same in every build
+    static inline std::uint64_t hash(std::string const& s) {
+        std::uint64_t h = 14695981039346656037ull;
+        for(auto c: s) {
+            h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    // the best time in seconds of reps calls of f
+    template <typename F>
+    double best_time(F&& f, int reps) {
+        using clock = std::chrono::steady_clock;
+        auto best = std::numeric_limits<double>::max();
+        for(auto i=0; i<reps; ++i) {
+            auto start = clock::now();
+            f();
+            std::chrono::duration<double> t = clock::now()-start;
+            best = std::min(best, t.count());
+        }
+        return best;
+    }
+
+    // the smallest size, in a sequence of increasing sizes, from which the
+    // candidate is faster than the baseline at every larger size
+    static inline size_type crossover(
+        std::vector<size_type> const& sizes,
+        std::vector<double> const& baseline,
+        std::vector<double> const& candidate)
+    {
+        auto threshold = never;
+        for(auto i=sizes.size(); i>0; --i) {
+            if(candidate[i-1]>=baseline[i-1]) {
+                break;
+            }
+            threshold = sizes[i-1];
+        }
+        return threshold;
+    }
+} // namespace impl
+
+// the path of the cache file for this host
+static inline std::string cache_path() {
+    if(auto path = std::getenv("MEMORY_CALIBRATION_FILE")) {
+        return path;
+    }
+    auto home = std::getenv("HOME");
+    if(home==nullptr) {
+        return "";
+    }
+    std::stringstream path;
+    path << home << "/.cache/memory-calibration-"
+         << std::hex << impl::hash(cpu_model()) << ".txt";
+    return path.str();
+}
+
+// measure the thresholds on this host, using buffers of at most max_bytes
+// bytes, or a multiple of the last level cache if zero
+static inline Result measure(size_type max_bytes = 0) {
+    if(max_bytes==0) {
+        auto llc = bulk::last_level_cache_bytes();
+        max_bytes = std::min(llc ? 16*llc : size_type(1)<<28, size_type(1)<<30);
+    }
+    max_bytes = std::max(max_bytes, size_type(1)<<16);
+
+    std::vector<size_type> sizes;
+    for(auto bytes=size_type(1)<<14; bytes<=max_bytes; bytes*=2) {
+        sizes.push_back(bytes);
+    }
+
+    // touch every page once before timing
+    std::vector<char> from(max_bytes, 1);
+    std::vector<char> to(max_bytes, 0);
+
+    Result result;
+    result.num_threads = threading::hardware_threads();
+
+    std::vector<double> memcpy_time, stream_time, team_time;
+    for(auto bytes: sizes) {
+        // fewer repetitions for large sizes keeps the total time bounded
+        auto reps = int(std::max(size_type(3), (size_type(1)<<24)/bytes));
+
+        memcpy_time.push_back(impl::best_time(
+            [&] {bulk::copy(from.data(), bytes, to.data(), bulk::kBulkMemory);},
+            reps));
+
+        stream_time.push_back(impl::best_time(
+            [&] {bulk::copy(from.data(), bytes, to.data(), bulk::kBulkNonTemporal);},
+            reps));
+
+        SplitRange split(Range(0, bytes), result.num_threads);
+        team_time.push_back(impl::best_time(
+            [&] {
+                auto src = from.data();
+                auto dst = to.data();
+                threading::for_each_chunk(split,
+                    [src, dst](size_type, Range r) {
+                        bulk::copy(src+r.left(), r.size(), dst+r.left(),
+                                   bulk::kBulkMemory);
+                    });
+            },
+            reps));
+    }
+
+    if(bulk::have_nontemporal_stores()) {
+        result.nontemporal_threshold =
+            impl::crossover(sizes, memcpy_time, stream_time);
+    }
+    if(result.num_threads>1) {
+        result.parallel_threshold =
+            impl::crossover(sizes, memcpy_time, team_time);
+    }
+    if(result.parallel_threshold==never) {
+        result.num_threads = 1;
+    }
+
+    return result;
+}
+
+// save result in the file at path
+// returns false if the file could not be written
+static inline bool save(Result const& result, std::string const& path) {
+    if(path.empty()) {
+        return false;
+    }
+
+    // make the cache directory if needed, which is the only directory that
+    // is created: an explicit MEMORY_CALIBRATION_FILE must be in an
+    // existing directory
+    auto dir = path.substr(0, path.find_last_of('/'));
+    if(dir!=path) {
+        mkdir(dir.c_str(), 0755);
+    }
+
+    std::ofstream file(path);
+    file << "cpu " << cpu_model() << "\n" << result;
+    return bool(file);
+}
+
+// load the result saved in the file at path into result
+// returns false if there is no such file, or it was saved on another CPU model
+static inline bool load(std::string const& path, Result& result) {
+    std::ifstream file(path);
+    if(!file) {
+        return false;
+    }
+
+    std::string line;
+    if(!std::getline(file, line) || line!="cpu "+cpu_model()) {
+        return false;
+    }
+
+    Result r;
+    auto fields = 0;
+    while(std::getline(file, line)) {
+        std::istringstream in(line);
+        std::string key;
+        in >> key;
+        if     (key=="nontemporal_threshold") fields += bool(in >> r.nontemporal_threshold);
+        else if(key=="parallel_threshold")    fields += bool(in >> r.parallel_threshold);
+        else if(key=="num_threads")           fields += bool(in >> r.num_threads);
+    }
+    if(fields!=3 || r.num_threads==0) {
+        return false;
+    }
+
+    result = r;
+    return true;
+}
+
+// use result for HostCoordinator::copy and HostCoordinator::set
+static inline void apply(Result const& result) {
+    bulk::settings().nontemporal_threshold = result.nontemporal_threshold;
+    threading::transfer_settings().parallel_threshold = result.parallel_threshold;
+    threading::transfer_settings().num_threads = result.num_threads;
+}
+
+// load the cached result for this host, or measure and cache it if there
+// is none, and apply it
+static inline Result calibrate() {
+    Result result;
+    auto path = cache_path();
+    if(!load(path, result)) {
+        result = measure();
+        save(result, path);
+    }
+    apply(result);
+    return result;
+}
+
+} // namespace calibration
+} // namespace memory
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <ostream>
+#include <vector>
+
+#include <cassert>
+
+#include "definitions.hpp"
+#include "Allocator.hpp"
+#include "Range.hpp"
+#include "SplitRange.hpp"
+
+namespace memory {
+
+// The ways in which ChunkDispenser sizes the chunks that it hands out
+enum DispenseMode {
+    // chunks of grain values
+    kDispenseDynamic,
+
+    // chunks of the remaining values divided by the number of threads, so
+    // that chunks shrink as the range is consumed, but at least grain values
+    kDispenseGuided
+};
+
+// Hands out chunks of a range, in order, to threads that ask for the next
+// chunk when they finish their last one, for irregular loops where a static
+// split would leave threads idle, and the work is not recursive, e.g.
+//
+//  ChunkDispenser chunks(Range(0, n), 64, kDispenseGuided, num_threads);
+//  for(auto step=0; step<num_steps; ++step) {
+//      chunks.reset();
+//      #pragma omp parallel
+//      {
+//          auto thread = omp_get_thread_num();
+//          Range r;
+//          while(chunks.next(r, thread)) {
+//              ...
+//          }
+//      }
+//  }
+//
+// Chunks are taken from a shared atomic cursor, without locks: with
+// kDispenseDynamic by one atomic add, and with kDispenseGuided by a compare
+// and swap loop. The number of chunks taken by each thread is counted, with
+// the counter of every thread on its own cache line.
+//
+// reset() starts again from the beginning of the range, without allocating
+// memory, so one dispenser can be reused every iteration of a loop.
+//
+// The cursor is aligned to a cache line, so a dispenser should be a local or
+// member variable, because operator new is not guaranteed to align it before
+// C++17.
+class ChunkDispenser {
+  public:
+    using size_type       = Range::size_type;
+    using difference_type = Range::difference_type;
+
+    // hand out rng in chunks of grain values, or in guided chunks of at
+    // least grain values, to num_threads threads numbered [0, num_threads)
+    ChunkDispenser(Range const& rng, size_type grain,
+                   DispenseMode mode=kDispenseDynamic,
+                   size_type num_threads=1)
+    :   range_(rng),
+        grain_(grain),
+        mode_(mode),
+        counts_(num_threads)
+    {
+        assert(grain>0);
+        assert(num_threads>0);
+        reset();
+    }
+
+    ChunkDispenser(ChunkDispenser const&) = delete;
+    ChunkDispenser& operator=(ChunkDispenser const&) = delete;
+
+    // take the next chunk for thread
+    // returns false, and leaves chunk unchanged, when the range is finished
+    bool next(Range& chunk, size_type thread=0) {
+        assert(thread<counts_.size());
+
+        auto right = range_.right();
+        size_type first, last;
+        if(mode_==kDispenseDynamic) {
+            first = cursor_.fetch_add(grain_, std::memory_order_relaxed);
+            if(first>=right) {
+                return false;
+            }
+            last = std::min(first+grain_, right);
+        }
+        else {
+            first = cursor_.load(std::memory_order_relaxed);
+            do {
+                if(first>=right) {
+                    return false;
+                }
+                auto size = std::max(grain_, (right-first)/counts_.size());
+                last = std::min(first+size, right);
+            } while(!cursor_.compare_exchange_weak(
+                        first, last, std::memory_order_relaxed));
+        }
+
+        chunk = Range(first, last);
+        auto& count = counts_[thread].value;
+        count.store(count.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // start again from the beginning of the range, and clear the counts
+    // must not be called while threads are taking chunks
+    void reset() {
+        cursor_.store(range_.left(), std::memory_order_relaxed);
+        for(auto& c: counts_) {
+            c.value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // start again with a new range
+    void reset(Range const& rng) {
+        range_ = rng;
+        reset();
+    }
+
+    // the number of chunks taken by thread since the last reset
+    size_type chunks_taken(size_type thread) const {
+        assert(thread<counts_.size());
+        return counts_[thread].value.load(std::memory_order_relaxed);
+    }
+
+    // the number of chunks taken by all threads since the last reset
+    size_type chunks_taken() const {
+        size_type sum = 0;
+        for(auto const& c: counts_) {
+            sum += c.value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    size_type num_threads() const {
+        return counts_.size();
+    }
+
+    size_type grain() const {
+        return grain_;
+    }
+
+    DispenseMode mode() const {
+        return mode_;
+    }
+
+    Range range() const {
+        return range_;
+    }
+
+  private:
+    // a counter that is only written by one thread, aligned to a cache line
+    // so that threads don't write to the same line
+    struct alignas(impl::cache_line_bytes) counter {
+        counter() : value(0) {}
+        counter(counter const& other) : value(other.value.load()) {}
+
+        std::atomic<size_type> value;
+    };
+    using counter_allocator = AlignedAllocator<counter, impl::cache_line_bytes>;
+
+    Range range_;
+    size_type grain_;
+    DispenseMode mode_;
+    std::vector<counter, counter_allocator> counts_;
+
+    // the first value that has not been handed out, on its own cache line
+    // the alignment also rounds the size of a dispenser up to a whole line
+    alignas(impl::cache_line_bytes) std::atomic<size_type> cursor_;
+};
+
+// overload output operator for chunk dispenser
+inline std::ostream& operator << (std::ostream& os, const ChunkDispenser& chunks) {
+    os << "(" << chunks.range()
+       << (chunks.mode()==kDispenseDynamic ? " dynamic" : " guided")
+       << " by " << chunks.grain() << ")";
+    return os;
+}
+
+} // namespace memory
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <cassert>
+
+#include "definitions.hpp"
+#include "Range.hpp"
+
+namespace memory {
+
+// A batch of many small copies between arrays, e.g. the halo and ghost cell
+// exchanges of one time step, that is performed as one operation by the
+// copy_batch() member of a coordinator, e.g.
+//
+//  CopyBatch<double> halo;
+//  for(auto& h: halos) {
+//      halo.add(field(h.source), field(h.ghost));
+//  }
+//  for(auto step=0; step<num_steps; ++step) {
+//      ...
+//      coordinator.copy_batch(halo);
+//  }
+//
+// The copies are sorted by source address, and copies that are contiguous
+// in both source and destination are merged into one. This is done once, when
+// the batch is first used after copies were added, so batches can be built
+// once and reused. Copies in a batch must not overlap.
+//
+// The batch only holds pointers, so the same batch type can be used by any
+// coordinator: a coordinator implements the copies with copy_batch(), by
+// copying each of segments(), or by copying the elements in sub-ranges of
+// [0, size()) with for_each_segment() on different threads.
+template <typename T>
+class CopyBatch {
+public:
+    using value_type = T;
+    using size_type  = types::size_type;
+
+    using pointer       = value_type*;
+    using const_pointer = const value_type*;
+
+    struct segment {
+        const_pointer from;
+        pointer to;
+        size_type size;
+    };
+
+    // add a copy from the view from to the view to, which must have the same size
+    template <typename From, typename To>
+    void add(From const& from, To&& to) {
+        assert(from.size()==to.size());
+        add(from.data(), to.data(), from.size());
+    }
+
+    // add a copy of n values from from to to
+    void add(const_pointer from, pointer to, size_type n) {
+        if(n) {
+            segments_.push_back({from, to, n});
+            num_copies_++;
+            coalesced_ = false;
+        }
+    }
+
+    // remove all copies
+    void clear() {
+        segments_.clear();
+        offsets_.clear();
+        num_copies_ = 0;
+        coalesced_ = true;
+    }
+
+    // the number of copies that have been added
+    size_type num_copies() const {
+        return num_copies_;
+    }
+
+    // the total number of values copied by the batch
+    size_type size() {
+        coalesce();
+        return offsets_.empty() ? 0 : offsets_.back();
+    }
+
+    // the merged copies, sorted by source address
+    std::vector<segment> const& segments() {
+        coalesce();
+        return segments_;
+    }
+
+    // call f(s) for the part s of every segment that holds the values in r,
+    // where the values of the batch are numbered in the order of segments()
+    template <typename F>
+    void for_each_segment(Range r, F&& f) {
+        coalesce();
+        if(r.size()==0) {
+            return;
+        }
+
+        // the first segment that ends after r.left()
+        auto i = std::upper_bound(offsets_.begin()+1, offsets_.end(), r.left())
+               - offsets_.begin() - 1;
+        for(auto pos=r.left(); pos<r.right(); ++i) {
+            auto const& s = segments_[i];
+            auto first = pos-offsets_[i];
+            auto last  = std::min(s.size, r.right()-offsets_[i]);
+            f(segment{s.from+first, s.to+first, last-first});
+            pos = offsets_[i]+last;
+        }
+    }
+
+private:
+    // sort the copies by source address, merge neighbours that are contiguous
+    // in both source and destination, and calculate the offsets of segments
+    void coalesce() {
+        if(coalesced_) {
+            return;
+        }
+
+        std::sort(segments_.begin(), segments_.end(),
+            [](segment const& a, segment const& b) {return a.from<b.from;});
+
+        std::vector<segment> merged;
+        merged.reserve(segments_.size());
+        for(auto const& s: segments_) {
+            if(!merged.empty()) {
+                auto& last = merged.back();
+                if(last.from+last.size==s.from && last.to+last.size==s.to) {
+                    last.size += s.size;
+                    continue;
+                }
+            }
+            merged.push_back(s);
+        }
+        segments_.swap(merged);
+
+        offsets_.resize(segments_.size()+1);
+        offsets_[0] = 0;
+        for(auto i=0u; i<segments_.size(); ++i) {
+            offsets_[i+1] = offsets_[i] + segments_[i].size;
+        }
+
+        coalesced_ = true;
+    }
+
+    std::vector<segment> segments_;
+    // offsets_[i] is the number of values copied by segments before i
+    std::vector<size_type> offsets_;
+    size_type num_copies_ = 0;
+    bool coalesced_ = true;
+};
+
+} // namespace memory
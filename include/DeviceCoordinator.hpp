@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <exception>
 
+#include "AllocationStats.hpp"
 #include "Allocator.hpp"
 #include "Array.hpp"
 #include "definitions.hpp"
@@ -152,8 +153,14 @@ private:
 };
 
 
+// A stateless allocator is stored as an empty base, as in HostCoordinator.
 template <typename T, class Allocator_=CudaAllocator<T> >
-class DeviceCoordinator {
+class DeviceCoordinator
+    : private impl::ebo_storage<
+        typename Allocator_::template rebind<T>, DeviceCoordinator<T, Allocator_>>
+{
+    using allocator_storage = impl::ebo_storage<
+        typename Allocator_::template rebind<T>, DeviceCoordinator<T, Allocator_>>;
 public:
     using value_type = T;
     using Allocator = typename Allocator_::template rebind<value_type>;
@@ -171,10 +178,30 @@ public:
     template <typename Tother>
     using rebind = DeviceCoordinator<Tother, Allocator>;
 
+    DeviceCoordinator() = default;
+
+    // construct with an allocator instance, which is used to allocate and
+    // free memory, for allocators with state
+    explicit DeviceCoordinator(Allocator const& allocator)
+    :   allocator_storage(allocator)
+    {}
+
+    // construct from a coordinator for another type, sharing its allocator
+    template <typename Tother>
+    DeviceCoordinator(DeviceCoordinator<Tother, Allocator> const& other)
+    :   allocator_storage(other.allocator())
+    {}
+
+    Allocator const& allocator() const {
+        return allocator_storage::get();
+    }
+
     view_type allocate(size_type n) {
-        Allocator allocator;
+        pointer ptr = n>0 ? allocator_storage::get().allocate(n) : nullptr;
 
-        pointer ptr = n>0 ? allocator.allocate(n) : nullptr;
+        #ifdef WITH_MEMORY_STATS
+        stats::record_allocate<Allocator>(ptr, n*sizeof(value_type));
+        #endif
 
         #ifdef VERBOSE
         std::cerr << util::type_printer<DeviceCoordinator>::print()
@@ -187,10 +214,12 @@ public:
     }
 
     void free(view_type& rng) {
-        Allocator allocator;
-
-        if(rng.data())
-            allocator.deallocate(rng.data(), rng.size());
+        if(rng.data()) {
+            #ifdef WITH_MEMORY_STATS
+            stats::record_free(rng.data());
+            #endif
+            allocator_storage::get().deallocate(rng.data(), rng.size());
+        }
 
         #ifdef VERBOSE
         std::cerr << util::type_printer<DeviceCoordinator>::print()
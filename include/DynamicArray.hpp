@@ -0,0 +1,326 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+#include <sys/mman.h>
+
+#include "AllocationStats.hpp"
+#include "Array.hpp"
+#include "ArrayView.hpp"
+#include "definitions.hpp"
+#include "HostCoordinator.hpp"
+#include "util.hpp"
+
+namespace memory {
+
+// forward declarations
+template <typename T, typename Coord>
+class DynamicArray;
+
+namespace util {
+    template <typename T, typename Coord>
+    struct type_printer<DynamicArray<T,Coord>>{
+        static std::string print() {
+            std::stringstream str;
+            str << util::white("DynamicArray") << "<"
+                << type_printer<Coord>::print() << ">";
+            return str.str();
+        }
+    };
+
+    template <typename T, typename Coord>
+    struct pretty_printer<DynamicArray<T,Coord>>{
+        static std::string print(const DynamicArray<T,Coord>& val) {
+            std::stringstream str;
+            str << type_printer<DynamicArray<T,Coord>>::print()
+                << "(size="     << val.size()
+                << ", capacity=" << val.capacity()
+                << ", pointer=" << val.data() << ")";
+            return str.str();
+        }
+    };
+}
+
+namespace impl {
+    template <typename T, typename Coord>
+    struct is_array_by_value<DynamicArray<T, Coord> > : std::true_type {};
+}
+
+// True if a DynamicArray with coordinator Coord may bypass the coordinator,
+// and map and remap large buffers directly with mmap and mremap.
+// This is only true for host memory from the default aligned policy, which
+// mapped memory can replace without changing how the memory behaves. Other
+// policies (huge pages, pools, mapped files, pinned memory...) allocate all
+// buffers through the coordinator. Specialize this to opt in other policies.
+template <typename Coord>
+struct is_remappable : std::false_type {};
+
+template <typename T, size_t Alignment>
+struct is_remappable<HostCoordinator<T, AlignedAllocator<T, Alignment>>>
+    : std::integral_constant<bool, (Alignment<=4096)> {};
+
+// A growable array in host memory, with push_back(), resize() and reserve().
+// Like Array, it owns its memory and derives from ArrayView, so sub-ranges
+// are accessed through views in the same way.
+//
+// Buffers are allocated by the coordinator of the array and grown
+// geometrically by copying. When is_remappable<Coord> holds, buffers of at
+// least remap_threshold bytes are instead mapped directly with mmap, and grown
+// with mremap, which moves the pages to a new virtual address range without
+// copying them.
+//
+// Views and pointers into the array are invalidated when it grows.
+template <typename T, typename Coord=HostCoordinator<T>>
+class DynamicArray
+    : public ArrayView<T, Coord> {
+public:
+    using value_type = T;
+    using base       = ArrayView<value_type, Coord>;
+    using view_type  = ArrayView<value_type, Coord>;
+    using const_view_type  = ConstArrayView<value_type, Coord>;
+
+    using coordinator_type = typename Coord::template rebind<value_type>;
+
+    using size_type       = typename base::size_type;
+    using difference_type = typename base::difference_type;
+
+    using pointer       = value_type*;
+    using const_pointer = const value_type*;
+
+    static_assert(std::is_trivially_copyable<value_type>::value,
+            "DynamicArray moves its elements with memcpy and mremap");
+
+    // buffers of at least this many bytes are grown with mremap, if the
+    // coordinator allows it
+    static constexpr size_type remap_threshold = size_type(1)<<21;
+    static constexpr size_type page_size = 4096;
+    static constexpr bool remappable = is_remappable<coordinator_type>::value;
+
+    // As for Array, the constructors take an optional coordinator, which
+    // allocates and frees the memory of the array. The coordinator is copied
+    // by the copy constructor, moves with the memory, and is kept by the
+    // array that is assigned to.
+    DynamicArray() : base(nullptr, 0) {}
+
+    explicit DynamicArray(coordinator_type const& coordinator)
+        : base(nullptr, 0, coordinator)
+    {}
+
+    explicit DynamicArray(size_type n,
+                          coordinator_type const& coordinator=coordinator_type())
+        : base(nullptr, 0, coordinator)
+    {
+        resize(n);
+    }
+
+    DynamicArray(size_type n, value_type value,
+                 coordinator_type const& coordinator=coordinator_type())
+        : base(nullptr, 0, coordinator)
+    {
+        resize(n, value);
+    }
+
+    DynamicArray(DynamicArray const& other)
+        : base(nullptr, 0, other.coordinator())
+    {
+        assign(other);
+    }
+
+    // construct as a copy of an Array or view in the same memory space
+    explicit DynamicArray(const_view_type const& other,
+                          coordinator_type const& coordinator=coordinator_type())
+        : base(nullptr, 0, coordinator)
+    {
+        assign(other);
+    }
+
+    DynamicArray(DynamicArray&& other)
+        : base(nullptr, 0, other.coordinator())
+    {
+        swap(other);
+    }
+
+    DynamicArray& operator=(DynamicArray const& other) {
+        if(this != &other) {
+            clear();
+            assign(other);
+        }
+        return *this;
+    }
+
+    DynamicArray& operator=(DynamicArray&& other) {
+        swap(other);
+        return *this;
+    }
+
+    ~DynamicArray() {
+        release();
+    }
+
+    // the number of elements that can be stored without growing
+    size_type capacity() const {
+        return capacity_;
+    }
+
+    // true if the storage is grown with mremap
+    bool is_mapped() const {
+        return mapped_;
+    }
+
+    const coordinator_type& coordinator() const {
+        return base::get_coordinator();
+    }
+
+    // make the capacity at least n
+    void reserve(size_type n) {
+        if(n<=capacity_) {
+            return;
+        }
+
+        auto bytes = n*sizeof(value_type);
+        if(remappable && bytes>=remap_threshold) {
+            grow_mapped(bytes);
+        }
+        else {
+            grow_allocated(n);
+        }
+    }
+
+    // resize to n elements, leaving new elements uninitialized
+    void resize(size_type n) {
+        reserve(n);
+        base::reset(data(), n);
+    }
+
+    // resize to n elements, setting new elements to value
+    void resize(size_type n, value_type value) {
+        auto old_size = size();
+        resize(n);
+        if(n>old_size) {
+            std::fill(data()+old_size, data()+n, value);
+        }
+    }
+
+    void push_back(value_type value) {
+        auto n = size();
+        if(n==capacity_) {
+            reserve(n ? 2*n : 1);
+        }
+        data()[n] = value;
+        base::reset(data(), n+1);
+    }
+
+    void pop_back() {
+        assert(size()>0);
+        base::reset(data(), size()-1);
+    }
+
+    // set the size to zero, keeping the capacity
+    void clear() {
+        base::reset(data(), 0);
+    }
+
+    using base::operator();
+    using base::data;
+    using base::size;
+
+private:
+    void assign(const_view_type const& other) {
+        resize(other.size());
+        if(other.size()) {
+            std::memcpy(data(), other.data(), other.size()*sizeof(value_type));
+        }
+    }
+
+    void swap(DynamicArray& other) {
+        base::swap(other);
+        std::swap(base::get_coordinator(), other.get_coordinator());
+        std::swap(capacity_, other.capacity_);
+        std::swap(mapped_, other.mapped_);
+    }
+
+    // geometric growth of memory allocated by the coordinator
+    void grow_allocated(size_type n) {
+        auto storage = base::get_coordinator().allocate(n);
+        if(size()) {
+            std::memcpy(storage.data(), data(), size()*sizeof(value_type));
+        }
+        auto n_used = size();
+        release();
+        base::reset(storage.data(), n_used);
+        capacity_ = n;
+    }
+
+    // grow mapped storage, moving existing pages with mremap where possible
+    // the memory is attributed to the coordinator in the allocation stats
+    void grow_mapped(size_type bytes) {
+        static_assert(!remappable || coordinator_type::alignment()<=page_size,
+                "mapped storage can only guarantee page alignment");
+
+        bytes = (bytes+page_size-1)/page_size*page_size;
+        auto n_used = size();
+
+        void* ptr = nullptr;
+#ifdef MREMAP_MAYMOVE
+        if(mapped_) {
+            ptr = mremap(data(), capacity_*sizeof(value_type), bytes, MREMAP_MAYMOVE);
+            if(ptr == MAP_FAILED) {
+                std::cerr << util::red("error") << " memory:: unable to remap "
+                          << bytes << " bytes" << std::endl;
+                exit(-1);
+            }
+            #ifdef WITH_MEMORY_STATS
+            stats::record_free(data());
+            stats::record_allocate<typename coordinator_type::allocator_type>(ptr, bytes);
+            #endif
+            base::reset(reinterpret_cast<pointer>(ptr), n_used);
+            capacity_ = bytes/sizeof(value_type);
+            return;
+        }
+#endif
+
+        ptr = mmap(nullptr, bytes, PROT_READ|PROT_WRITE,
+                   MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if(ptr == MAP_FAILED) {
+            std::cerr << util::red("error") << " memory:: unable to map "
+                      << bytes << " bytes" << std::endl;
+            exit(-1);
+        }
+        #ifdef WITH_MEMORY_STATS
+        stats::record_allocate<typename coordinator_type::allocator_type>(ptr, bytes);
+        #endif
+        if(n_used) {
+            std::memcpy(ptr, data(), n_used*sizeof(value_type));
+        }
+        release();
+        base::reset(reinterpret_cast<pointer>(ptr), n_used);
+        capacity_ = bytes/sizeof(value_type);
+        mapped_ = true;
+    }
+
+    // free the storage, leaving an empty array with no capacity
+    void release() {
+        if(mapped_) {
+            #ifdef WITH_MEMORY_STATS
+            stats::record_free(data());
+            #endif
+            munmap(data(), capacity_*sizeof(value_type));
+            base::reset();
+        }
+        else {
+            view_type storage(data(), capacity_, base::get_coordinator());
+            base::get_coordinator().free(storage);
+            base::reset();
+        }
+        capacity_ = 0;
+        mapped_ = false;
+    }
+
+    size_type capacity_ = 0;
+    bool mapped_ = false;
+};
+
+} // namespace memory
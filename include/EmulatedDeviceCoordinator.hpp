@@ -0,0 +1,383 @@
+#pragma once
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#include "AllocationStats.hpp"
+#include "Allocator.hpp"
+#include "Array.hpp"
+#include "BulkMemory.hpp"
+#include "definitions.hpp"
+#include "EmulatedEvent.hpp"
+#include "EmulatedStream.hpp"
+#include "Event.hpp"
+#include "util.hpp"
+
+// A memory space in host memory that behaves like GPU memory, so that code
+// that transfers memory between host and device, and overlaps transfers
+// with streams and events, can be tested and timed on nodes without a GPU.
+//
+// EmulatedDeviceCoordinator mirrors DeviceCoordinator:
+//  - elements are accessed through proxy references, which synchronize with
+//    the default stream like cudaMemcpy, instead of through raw pointers
+//  - set() is queued on the default stream like a fill kernel
+//  - copies between host and device are synchronous, and copy_async()
+//    queues them on an EmulatedStream and returns an EmulatedEvent
+//
+// The bandwidth and latency of transfers between host and device can be set
+// in emulation_settings() to emulate a PCIe bus.
+
+namespace memory {
+
+// forward declare
+template <typename T, class Allocator>
+class EmulatedDeviceCoordinator;
+
+template <typename T, class Allocator>
+class HostCoordinator;
+
+struct EmulationSettings {
+    // bytes per second of transfers between host and device, or unlimited
+    // if zero
+    double bandwidth = 0;
+
+    // seconds added to every transfer between host and device
+    double latency = 0;
+};
+
+// the settings shared by all translation units
+inline EmulationSettings& emulation_settings() {
+    static EmulationSettings settings;
+    return settings;
+}
+
+namespace impl {
+    namespace emulated {
+        // memory has the same 256 byte alignment as cudaMalloc
+        constexpr size_type device_alignment = 256;
+
+        // allocates "device" memory on the host
+        class DevicePolicy {
+        public:
+            void *allocate_policy(size_type size) {
+                return reinterpret_cast<void *>
+                            (aligned_malloc<char, device_alignment>(size));
+            }
+
+            void free_policy(void *ptr) {
+                free(ptr);
+            }
+
+            static constexpr size_type alignment() {
+                return device_alignment;
+            }
+            static constexpr bool is_malloc_compatible() {
+                return true;
+            }
+        };
+
+        // copy n values with the emulated bandwidth and latency
+        template <typename T>
+        void transfer(T const* from, size_type n, T* to) {
+            auto start = std::chrono::steady_clock::now();
+            bulk::copy(from, n, to);
+
+            auto const& settings = emulation_settings();
+            auto seconds = settings.latency;
+            if(settings.bandwidth>0) {
+                seconds += n*sizeof(T)/settings.bandwidth;
+            }
+            if(seconds>0) {
+                std::this_thread::sleep_until(
+                    start + std::chrono::duration<double>(seconds));
+            }
+        }
+
+        // wait for all work in the default stream to finish
+        static inline void synchronize() {
+            EmulatedStream().synchronize();
+        }
+    } // namespace emulated
+} // namespace impl
+
+namespace util {
+    template <>
+    struct type_printer<impl::emulated::DevicePolicy>{
+        static std::string print() {
+            return std::string("EmulatedDevicePolicy");
+        }
+    };
+
+    template <typename T, typename Allocator>
+    struct type_printer<EmulatedDeviceCoordinator<T,Allocator>>{
+        static std::string print() {
+            #if VERBOSE > 1
+            return util::white("EmulatedDeviceCoordinator") + "<"
+                + type_printer<T>::print()
+                + ", " + type_printer<Allocator>::print() + ">";
+            #else
+            return util::white("EmulatedDeviceCoordinator")
+                + "<" + type_printer<T>::print() + ">";
+            #endif
+        }
+    };
+
+    template <typename T, typename Allocator>
+    struct pretty_printer<EmulatedDeviceCoordinator<T,Allocator>>{
+        static std::string print(const EmulatedDeviceCoordinator<T,Allocator>& val) {
+            return type_printer<EmulatedDeviceCoordinator<T,Allocator>>::print();
+        }
+    };
+} // namespace util
+
+template <class T>
+using EmulatedDeviceAllocator = Allocator<T, impl::emulated::DevicePolicy>;
+
+template <typename T>
+class ConstEmulatedDeviceReference {
+public:
+    using value_type = T;
+    using pointer = value_type*;
+
+    ConstEmulatedDeviceReference(pointer p) : pointer_(p) {}
+
+    operator T() const {
+        impl::emulated::synchronize();
+        T tmp;
+        std::memcpy(&tmp, pointer_, sizeof(T));
+        return tmp;
+    }
+
+protected:
+    template <typename Other>
+    void operator =(Other&&) {}
+
+    pointer pointer_;
+};
+
+template <typename T>
+class EmulatedDeviceReference {
+public:
+    using value_type = T;
+    using pointer = value_type*;
+
+    EmulatedDeviceReference(pointer p) : pointer_(p) {}
+
+    EmulatedDeviceReference& operator = (const T& value) {
+        impl::emulated::synchronize();
+        std::memcpy(pointer_, &value, sizeof(T));
+        return *this;
+    }
+
+    operator T() const {
+        impl::emulated::synchronize();
+        T tmp;
+        std::memcpy(&tmp, pointer_, sizeof(T));
+        return tmp;
+    }
+
+private:
+    pointer pointer_;
+};
+
+// A stateless allocator is stored as an empty base, as in HostCoordinator.
+template <typename T, class Allocator_=EmulatedDeviceAllocator<T> >
+class EmulatedDeviceCoordinator
+    : private impl::ebo_storage<
+        typename Allocator_::template rebind<T>, EmulatedDeviceCoordinator<T, Allocator_>>
+{
+    using allocator_storage = impl::ebo_storage<
+        typename Allocator_::template rebind<T>, EmulatedDeviceCoordinator<T, Allocator_>>;
+public:
+    using value_type = T;
+    using Allocator = typename Allocator_::template rebind<value_type>;
+
+    using pointer       = value_type*;
+    using const_pointer = const value_type*;
+    using reference       = EmulatedDeviceReference<value_type>;
+    using const_reference = ConstEmulatedDeviceReference<value_type>;
+
+    using view_type = ArrayView<value_type, EmulatedDeviceCoordinator>;
+
+    using size_type       = types::size_type;
+    using difference_type = types::difference_type;
+
+    template <typename Tother>
+    using rebind = EmulatedDeviceCoordinator<Tother, Allocator>;
+
+    EmulatedDeviceCoordinator() = default;
+
+    // construct with an allocator instance, which is used to allocate and
+    // free memory, for allocators with state
+    explicit EmulatedDeviceCoordinator(Allocator const& allocator)
+    :   allocator_storage(allocator)
+    {}
+
+    // construct from a coordinator for another type, sharing its allocator
+    template <typename Tother>
+    EmulatedDeviceCoordinator(EmulatedDeviceCoordinator<Tother, Allocator> const& other)
+    :   allocator_storage(other.allocator())
+    {}
+
+    Allocator const& allocator() const {
+        return allocator_storage::get();
+    }
+
+    template <typename Alloc>
+    using host_view_type = ArrayView<value_type, HostCoordinator<value_type, Alloc>>;
+
+    static_assert(std::is_trivially_copyable<value_type>::value,
+            "device memory can only hold trivially copyable types");
+
+    view_type allocate(size_type n) {
+        pointer ptr = n>0 ? allocator_storage::get().allocate(n) : nullptr;
+
+        #ifdef WITH_MEMORY_STATS
+        stats::record_allocate<Allocator>(ptr, n*sizeof(value_type));
+        #endif
+
+        #ifdef VERBOSE
+        std::cerr << util::type_printer<EmulatedDeviceCoordinator>::print()
+                  << util::blue("::allocate") << "(" << n << ")"
+                  << (ptr==nullptr && n>0 ? " failure" : " success")
+                  << std::endl;
+        #endif
+
+        return view_type(ptr, n);
+    }
+
+    // like cudaFree, this waits for work in the default stream that might
+    // still use the memory to finish
+    void free(view_type& rng) {
+        if(rng.data()) {
+            impl::emulated::synchronize();
+            #ifdef WITH_MEMORY_STATS
+            stats::record_free(rng.data());
+            #endif
+            allocator_storage::get().deallocate(rng.data(), rng.size());
+        }
+
+        #ifdef VERBOSE
+        std::cerr << util::type_printer<EmulatedDeviceCoordinator>::print()
+                  << "::free()" << std::endl;
+        #endif
+
+        impl::reset(rng);
+    }
+
+    // copy memory from one device range to another
+    void copy(const view_type &from, view_type &to) {
+        assert(from.size()==to.size());
+        assert(!from.overlaps(to));
+
+        auto src = from.data();
+        auto dst = to.data();
+        auto n = from.size();
+        EmulatedStream stream;
+        stream.enqueue([src, n, dst] {bulk::copy(src, n, dst);});
+        stream.synchronize();
+    }
+
+    // copy memory from host to device
+    template <class Alloc>
+    std::pair<SynchEvent, view_type>
+    copy(const host_view_type<Alloc> &from, view_type &to) {
+        assert(from.size()==to.size());
+
+        #ifdef VERBOSE
+        std::cout << util::pretty_printer<EmulatedDeviceCoordinator>::print(*this)
+                  << "::" << util::blue("copy") << "(host2device, " << from.size() << ")"
+                  << " " << from.data() << util::yellow(" -> ") << to.data()
+                  << std::endl;
+        #endif
+
+        EmulatedStream stream;
+        enqueue_transfer(stream, from.data(), from.size(), to.data());
+        stream.synchronize();
+
+        return std::make_pair(SynchEvent(), to);
+    }
+
+    // copy memory from device to host
+    template <class Alloc>
+    void copy(const view_type &from, host_view_type<Alloc> &to) {
+        assert(from.size()==to.size());
+
+        #ifdef VERBOSE
+        std::cout << util::pretty_printer<EmulatedDeviceCoordinator>::print(*this)
+                  << "::" << util::blue("copy") << "(device2host, " << from.size() << ")"
+                  << " " << from.data() << util::yellow(" -> ") << to.data()
+                  << std::endl;
+        #endif
+
+        EmulatedStream stream;
+        enqueue_transfer(stream, from.data(), from.size(), to.data());
+        stream.synchronize();
+    }
+
+    // queue a copy from host to device on stream, like cudaMemcpyAsync
+    // the returned event is ready when the copy has finished
+    template <class Alloc>
+    std::pair<EmulatedEvent, view_type>
+    copy_async(const host_view_type<Alloc> &from, view_type &to,
+               EmulatedStream stream=EmulatedStream())
+    {
+        assert(from.size()==to.size());
+
+        enqueue_transfer(stream, from.data(), from.size(), to.data());
+        return std::make_pair(stream.insert_event(), to);
+    }
+
+    // queue a copy from device to host on stream, like cudaMemcpyAsync
+    // the returned event is ready when the copy has finished
+    template <class Alloc>
+    std::pair<EmulatedEvent, host_view_type<Alloc>>
+    copy_async(const view_type &from, host_view_type<Alloc> &to,
+               EmulatedStream stream=EmulatedStream())
+    {
+        assert(from.size()==to.size());
+
+        enqueue_transfer(stream, from.data(), from.size(), to.data());
+        return std::make_pair(stream.insert_event(), to);
+    }
+
+    // fill memory
+    // like a fill kernel, this is queued on the default stream and returns
+    // immediately
+    void set(view_type &rng, value_type value) {
+        auto ptr = rng.data();
+        auto n = rng.size();
+        EmulatedStream().enqueue([ptr, n, value] {bulk::fill(ptr, n, value);});
+    }
+
+    // generate reference objects for a raw pointer.
+    reference make_reference(value_type* p) {
+        return reference(p);
+    }
+
+    const_reference make_reference(value_type const* p) const {
+        return const_reference(p);
+    }
+
+    static constexpr
+    auto alignment() -> decltype(Allocator_::alignment()) {
+        return Allocator_::alignment();
+    }
+
+    static constexpr
+    bool is_malloc_compatible() {
+        return Allocator_::is_malloc_compatible();
+    }
+
+private:
+    static void enqueue_transfer(
+        EmulatedStream& stream, const_pointer from, size_type n, pointer to)
+    {
+        stream.enqueue(
+            [from, n, to] {impl::emulated::transfer(from, n, to);});
+    }
+};
+
+} // namespace memory
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+#include "Event.hpp"
+
+namespace memory {
+
+class EmulatedStream;
+
+// An event in an EmulatedStream, with the same interface as CudaEvent.
+// Like a CudaEvent, an event that has not been inserted into a stream is
+// ready. Copies of an event share the same state.
+class EmulatedEvent
+: public AsynchEvent {
+public:
+    EmulatedEvent()
+    :   state_(std::make_shared<state>())
+    {}
+
+    // force host execution to wait for event completion
+    virtual void wait() override {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        state_->completed.wait(lock, [this] {return state_->ready;});
+    }
+
+    virtual EventStatus query() override {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->ready ? kEventReady : kEventBusy;
+    }
+
+    // returns time in seconds taken between this event and another event
+    // returns NaN if either event has not completed
+    // time is this - other
+    double time_since(EmulatedEvent& other) {
+        if(query()!=kEventReady || other.query()!=kEventReady) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        std::chrono::duration<double> t = state_->time - other.state_->time;
+        return t.count();
+    }
+
+private:
+    friend class EmulatedStream;
+
+    using clock = std::chrono::steady_clock;
+
+    struct state {
+        std::mutex mutex;
+        std::condition_variable completed;
+        bool ready = true;
+        clock::time_point time = clock::now();
+    };
+
+    // called by the stream when the event is inserted
+    void record() {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->ready = false;
+    }
+
+    // called by the stream when all work before the event has completed
+    void complete() {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->time = clock::now();
+        state_->ready = true;
+        state_->completed.notify_all();
+    }
+
+    std::shared_ptr<state> state_;
+};
+
+namespace util {
+    template <>
+    struct pretty_printer<EmulatedEvent>{
+        static std::string print(const EmulatedEvent&) {
+            return std::string("EmulatedEvent()");
+        }
+    };
+
+    template <>
+    struct type_printer<EmulatedEvent>{
+        static std::string print() {
+            return std::string("EmulatedEvent");
+        }
+    };
+} // namespace util
+
+} // namespace memory
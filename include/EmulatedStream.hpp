@@ -0,0 +1,72 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "EmulatedEvent.hpp"
+#include "Threading.hpp"
+
+namespace memory {
+
+// An in-order queue of work performed by a background host thread, with the
+// same interface as CudaStream, used by EmulatedDeviceCoordinator.
+//
+// Each stream created with create_new_stream has its own thread, and the
+// default stream is shared by all EmulatedStreams created without one.
+// Unlike the legacy CUDA default stream, the emulated default stream does
+// not synchronize with other streams.
+class EmulatedStream {
+public:
+    // default constructor
+    // sets to the default stream
+    EmulatedStream() : queue_(default_queue()) {}
+
+    // constructor with flag for whether or not to create a new stream
+    // if no stream is to be created, then the default stream is used
+    EmulatedStream(bool create_new_stream)
+    :   queue_(create_new_stream
+                    ? std::make_shared<threading::ThreadPool>(1)
+                    : default_queue())
+    {}
+
+    // returns boolean indicating whether this is the default stream
+    bool is_default_stream() {
+        return queue_==default_queue();
+    }
+
+    // add work to the end of the stream
+    // returns immediately
+    void enqueue(std::function<void()> task) {
+        queue_->enqueue(std::move(task));
+    }
+
+    // insert event into stream
+    // returns immediately
+    EmulatedEvent insert_event() {
+        EmulatedEvent e;
+        e.record();
+        enqueue([e]() mutable {e.complete();});
+        return e;
+    }
+
+    // make all future work on stream wait until event has completed
+    // returns immediately, not waiting for event to complete
+    void wait_on_event(EmulatedEvent &e) {
+        enqueue([e]() mutable {e.wait();});
+    }
+
+    // wait until all work in the stream has completed
+    void synchronize() {
+        insert_event().wait();
+    }
+
+private:
+    static std::shared_ptr<threading::ThreadPool> const& default_queue() {
+        static auto queue = std::make_shared<threading::ThreadPool>(1);
+        return queue;
+    }
+
+    std::shared_ptr<threading::ThreadPool> queue_;
+};
+
+} // namespace memory
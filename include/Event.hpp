@@ -1,5 +1,8 @@
 #pragma once
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <utility>
 
 #include "definitions.hpp"
@@ -105,6 +108,46 @@ public:
     }
 };
 
+// event for work that is performed asynchronously by host threads, e.g. by
+// HostCoordinator::copy_async()
+// the event is ready when signal() has been called num_signals times, by the
+// threads that perform the work. Copies of an event share the same state.
+class HostEvent
+: public AsynchEvent {
+public:
+    explicit HostEvent(unsigned num_signals=1)
+    :   state_(std::make_shared<state>(num_signals))
+    {}
+
+    // called by a thread when it has finished its part of the work
+    void signal() {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if(state_->pending && --state_->pending==0) {
+            state_->ready.notify_all();
+        }
+    }
+
+    virtual void wait() override {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        state_->ready.wait(lock, [this] {return state_->pending==0;});
+    }
+
+    virtual EventStatus query() override {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->pending ? kEventBusy : kEventReady;
+    }
+
+private:
+    struct state {
+        explicit state(unsigned n) : pending(n) {}
+        std::mutex mutex;
+        std::condition_variable ready;
+        unsigned pending;
+    };
+
+    std::shared_ptr<state> state_;
+};
+
 namespace util {
     template <>
     struct pretty_printer<SynchEvent>{
@@ -120,6 +163,13 @@ namespace util {
         }
     };
 
+    template <>
+    struct pretty_printer<HostEvent>{
+        static std::string print(const HostEvent&) {
+            return std::string("HostEvent()");
+        }
+    };
+
     template <>
     struct type_printer<SynchEvent>{
         static std::string print() {
@@ -127,6 +177,13 @@ namespace util {
         }
     };
 
+    template <>
+    struct type_printer<HostEvent>{
+        static std::string print() {
+            return std::string("HostEvent");
+        }
+    };
+
     template <>
     struct type_printer<CUDAEvent>{
         static std::string print() {
@@ -3,10 +3,17 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "definitions.hpp"
+#include "AllocationStats.hpp"
 #include "Array.hpp"
 #include "Allocator.hpp"
+#include "BulkMemory.hpp"
+#include "CopyBatch.hpp"
+#include "Event.hpp"
+#include "SplitRange.hpp"
+#include "Threading.hpp"
 
 namespace memory {
 
@@ -19,6 +26,9 @@ template <typename T, class Allocator>
 class DeviceCoordinator;
 #endif
 
+template <typename T, class Allocator>
+class EmulatedDeviceCoordinator;
+
 namespace util {
     template <typename T, typename Allocator>
     struct type_printer<HostCoordinator<T,Allocator>>{
@@ -40,8 +50,15 @@ namespace util {
     };
 } // namespace util
 
+// A stateless allocator is stored as an empty base, so that the coordinator,
+// and the views and arrays that hold one, take no space for it.
 template <typename T, class Allocator=AlignedAllocator<T> >
-class HostCoordinator {
+class HostCoordinator
+    : private impl::ebo_storage<
+        typename Allocator::template rebind<T>, HostCoordinator<T, Allocator>>
+{
+    using allocator_storage = impl::ebo_storage<
+        typename Allocator::template rebind<T>, HostCoordinator<T, Allocator>>;
 public:
     using value_type = T;
 
@@ -53,14 +70,36 @@ public:
     using size_type       = types::size_type;
     using difference_type = types::difference_type;
 
+    using allocator_type  = typename Allocator::template rebind<value_type>;
+
     // rebind host_coordinator with another type
     template <typename Tother>
     using rebind = HostCoordinator<Tother, Allocator>;
 
+    HostCoordinator() = default;
+
+    // construct with an allocator instance, which is used to allocate and
+    // free memory, for allocators with state
+    explicit HostCoordinator(allocator_type const& allocator)
+    :   allocator_storage(allocator)
+    {}
+
+    // construct from a coordinator for another type, sharing its allocator
+    template <typename Tother>
+    HostCoordinator(HostCoordinator<Tother, Allocator> const& other)
+    :   allocator_storage(other.allocator())
+    {}
+
+    allocator_type const& allocator() const {
+        return allocator_storage::get();
+    }
+
     view_type allocate(size_type n) {
-        typename Allocator::template rebind<value_type> allocator;
+        pointer ptr = n>0 ? allocator_storage::get().allocate(n) : nullptr;
 
-        pointer ptr = n>0 ? allocator.allocate(n) : nullptr;
+        #ifdef WITH_MEMORY_STATS
+        stats::record_allocate<allocator_type>(ptr, n*sizeof(value_type));
+        #endif
 
         #ifdef VERBOSE
         std::cerr << util::type_printer<HostCoordinator>::print()
@@ -73,8 +112,6 @@ public:
     }
 
     void free(view_type& rng) {
-        typename Allocator::template rebind<value_type> allocator;
-
         if(rng.data()) {
         #ifdef VERBOSE
             std::cerr << util::type_printer<HostCoordinator>::print()
@@ -85,12 +122,61 @@ public:
 
         #endif
 
-            allocator.deallocate(rng.data(), rng.size());
+            #ifdef WITH_MEMORY_STATS
+            stats::record_free(rng.data());
+            #endif
+
+            allocator_storage::get().deallocate(rng.data(), rng.size());
         }
 
         impl::reset(rng);
     }
 
+    // Allocate count arrays of n elements in a single block of memory, with
+    // the start of array i offset from a page boundary by i*colour_bytes more
+    // than array 0, where colour_bytes is rounded up to a multiple of the
+    // alignment. Arrays of the same length allocated separately start at the
+    // same offset in a page, so that streaming over them at the same time
+    // causes 4K aliasing and cache set conflicts, which this avoids.
+    // The arrays must be freed together with free_group().
+    std::vector<view_type>
+    allocate_group(size_type n, size_type count, size_type colour_bytes=64) {
+        const size_type page = 4096;
+        auto colour = (colour_bytes+alignment()-1)/alignment()*alignment();
+        auto stride = (n*sizeof(value_type)+page-1)/page*page + colour;
+
+        std::vector<view_type> group;
+        if(count==0) {
+            return group;
+        }
+
+        auto block = allocate(group_block_size(n, count, stride));
+        auto base  = reinterpret_cast<char*>(block.data());
+        for(size_type i=0; i<count; ++i) {
+            auto ptr = base ? reinterpret_cast<pointer>(base+i*stride) : nullptr;
+            group.push_back(view_type(ptr, ptr ? n : 0));
+        }
+
+        return group;
+    }
+
+    // free a group of arrays allocated with allocate_group()
+    // array 0 starts at the start of the block, and the size of the block is
+    // recovered from the length of the arrays and the distance between them
+    void free_group(std::vector<view_type>& group) {
+        if(!group.empty() && group[0].data()) {
+            auto n = group[0].size();
+            auto count = group.size();
+            auto stride = count>1
+                ? size_type(reinterpret_cast<char*>(group[1].data())
+                            - reinterpret_cast<char*>(group[0].data()))
+                : size_type(0);
+            auto block = view_type(group[0].data(), group_block_size(n, count, stride));
+            free(block);
+        }
+        group.clear();
+    }
+
     // copy memory between host memory ranges
     template <typename Allocator1, typename Allocator2>
     // requires Allocator1 = Allocator
@@ -110,7 +196,7 @@ public:
                   << std::endl;
         #endif
 
-        std::copy(from.begin(), from.end(), to.begin());
+        copy_n(from.data(), from.size(), to.data());
     }
 
     // copy memory between host memory ranges
@@ -132,7 +218,7 @@ public:
                   << std::endl;
         #endif
 
-        std::copy(from.begin(), from.end(), to.begin());
+        copy_n(from.data(), from.size(), to.data());
     }
 
     /*
@@ -180,6 +266,46 @@ public:
     }
 #endif
 
+    // perform all of the copies in batch, which must be between host memory
+    // ranges, splitting the values between a team of threads as for copy()
+    void copy_batch(CopyBatch<value_type>& batch) {
+        auto n = batch.size();
+
+        #ifdef VERBOSE
+        std::cerr << util::type_printer<HostCoordinator>::print()
+                  << "::" + util::blue("copy_batch") << "(" << batch.num_copies()
+                  << " copies in " << batch.segments().size() << " segments, "
+                  << n << " [" << n*sizeof(value_type) << " bytes])"
+                  << std::endl;
+        #endif
+
+        auto strategy = bulk::copy_strategy<value_type>(n);
+        auto copy_segment =
+            [strategy](typename CopyBatch<value_type>::segment const& s) {
+                bulk::copy(s.from, s.size, s.to, strategy);
+            };
+
+        if(!use_thread_team(n)) {
+            for(auto const& s: batch.segments()) {
+                copy_segment(s);
+            }
+            return;
+        }
+        SplitRange split(Range(0, n), threading::transfer_settings().num_threads,
+                         kSplitBalanced);
+        threading::for_each_chunk(split,
+            [&batch, &copy_segment](size_type, Range r) {
+                batch.for_each_segment(r, copy_segment);
+            });
+    }
+
+    // copy memory from emulated device to host
+    template <class Alloc>
+    void copy(const ArrayView<value_type, EmulatedDeviceCoordinator<value_type, Alloc>> &from,
+              view_type &to) {
+        EmulatedDeviceCoordinator<value_type, Alloc>().copy(from, to);
+    }
+
     // set all values in a range to val
     void set(view_type &rng, value_type val) {
         #ifdef VERBOSE
@@ -189,7 +315,74 @@ public:
                   << " @ " << rng.data()
                   << std::endl;
         #endif
-        std::fill(rng.begin(), rng.end(), val);
+        fill_n(rng.data(), rng.size(), val);
+    }
+
+    // set all values in a range to val, with the chunks of split filled by
+    // threads bound to cores, see threading::first_touch()
+    // the chunks are indexes into rng, so that the placement of pages under
+    // a first-touch policy follows the partition in split, which must cover
+    // all of rng
+    void set(view_type &rng, value_type val, SplitRange const& split) {
+        assert(split.range().left()==0 && split.range().right()==rng.size());
+
+        #ifdef VERBOSE
+        std::cerr << util::type_printer<HostCoordinator>::print()
+                  << "::" + util::blue("fill")
+                  << "(" << rng.size()  << " * " << val << ", " << split << ")"
+                  << " @ " << rng.data()
+                  << std::endl;
+        #endif
+
+        auto ptr = rng.data();
+        auto strategy = bulk::fill_strategy(rng.size(), val);
+        threading::first_touch(split,
+            [ptr, val, strategy](size_type, Range r) {
+                bulk::fill(ptr+r.left(), r.size(), val, strategy);
+            });
+    }
+
+    // Asynchronous copy and set, performed by the threads of
+    // threading::async_pool(), with the transfer split evenly between them.
+    // These return immediately, and the memory in from and to must remain
+    // valid, and not be modified, until the returned event is ready.
+    template <typename Allocator1, typename Allocator2>
+    HostEvent copy_async(
+        const ArrayView<value_type, HostCoordinator<value_type, Allocator1>>& from,
+              ArrayView<value_type, HostCoordinator<value_type, Allocator2>>& to)
+    {
+        assert(from.size()==to.size());
+        assert(!from.overlaps(to));
+
+        return copy_async_n(from.data(), from.size(), to.data());
+    }
+
+    template <typename Allocator1, typename Allocator2>
+    HostEvent copy_async(
+        const ConstArrayView<value_type, HostCoordinator<value_type, Allocator1>>& from,
+              ArrayView<value_type, HostCoordinator<value_type, Allocator2>>& to)
+    {
+        assert(from.size()==to.size());
+        assert(!from.overlaps(to));
+
+        return copy_async_n(from.data(), from.size(), to.data());
+    }
+
+    HostEvent set_async(view_type &rng, value_type val) {
+        #ifdef VERBOSE
+        std::cerr << util::type_printer<HostCoordinator>::print()
+                  << "::" + util::blue("fill")
+                  << "(asynchronous, " << rng.size()  << " * " << val << ")"
+                  << " @ " << rng.data()
+                  << std::endl;
+        #endif
+
+        auto ptr = rng.data();
+        auto strategy = bulk::fill_strategy(rng.size(), val);
+        return enqueue_chunks(rng.size(),
+            [ptr, val, strategy](Range r) {
+                bulk::fill(ptr+r.left(), r.size(), val, strategy);
+            });
     }
 
     reference make_reference(value_type* p) {
@@ -209,6 +402,96 @@ public:
     is_malloc_compatible() {
         return Allocator::is_malloc_compatible();
     }
+
+    // the width in bytes to which allocations are padded, or zero if the
+    // allocator does not pad
+    static constexpr size_type
+    padding() {
+        return impl::padding_width<Allocator>();
+    }
+
+private:
+    // the number of elements in the block that holds count arrays of n
+    // elements, with stride bytes between the starts of consecutive arrays
+    // allocate_group() and free_group() must agree on this
+    static size_type group_block_size(size_type n, size_type count, size_type stride) {
+        auto bytes = (count-1)*stride + n*sizeof(value_type);
+        return (bytes+sizeof(value_type)-1)/sizeof(value_type);
+    }
+
+    // copy and fill are split across a team of threads for transfers at least
+    // as large as the threshold in threading::transfer_settings()
+    // the bulk strategy (memcpy, memset, non-temporal stores...) is chosen
+    // for the size of the whole transfer, and used by every chunk
+    static bool use_thread_team(size_type n) {
+        auto const& settings = threading::transfer_settings();
+        return settings.num_threads>1
+            && n*sizeof(value_type)>=settings.parallel_threshold;
+    }
+
+    // split [0, n) into at most num_chunks chunks of similar size
+    // the boundaries of chunks are on cache lines of memory that starts on a
+    // cache line, e.g. arrays, so that no two threads write to the same line
+    static SplitRange team_split(size_type n, size_type num_chunks) {
+        return aligned_split<value_type>(Range(0, n), num_chunks);
+    }
+
+    static HostEvent copy_async_n(const_pointer from, size_type n, pointer to) {
+        #ifdef VERBOSE
+        std::cerr << util::type_printer<HostCoordinator>::print()
+                  << "::" + util::blue("copy") << "(asynchronous, " << n
+                  << " [" << n*sizeof(value_type) << " bytes])"
+                  << " " << from << util::yellow(" -> ") << to
+                  << std::endl;
+        #endif
+
+        auto strategy = bulk::copy_strategy<value_type>(n);
+        return enqueue_chunks(n,
+            [from, to, strategy](Range r) {
+                bulk::copy(from+r.left(), r.size(), to+r.left(), strategy);
+            });
+    }
+
+    // enqueue f(r) on the async pool for every chunk r of [0, n), and return
+    // an event that is ready when all chunks are finished
+    template <typename F>
+    static HostEvent enqueue_chunks(size_type n, F f) {
+        auto& pool = threading::async_pool();
+
+        // the split can have fewer chunks than requested
+        auto chunks = team_split(n, pool.size());
+        HostEvent event(chunks.size());
+        for(auto r: chunks) {
+            pool.enqueue([f, r, event]() mutable {f(r); event.signal();});
+        }
+        return event;
+    }
+
+    static void copy_n(const_pointer from, size_type n, pointer to) {
+        auto strategy = bulk::copy_strategy<value_type>(n);
+        if(!use_thread_team(n)) {
+            bulk::copy(from, n, to, strategy);
+            return;
+        }
+        auto split = team_split(n, threading::transfer_settings().num_threads);
+        threading::for_each_chunk(split,
+            [from, to, strategy](size_type, Range r) {
+                bulk::copy(from+r.left(), r.size(), to+r.left(), strategy);
+            });
+    }
+
+    static void fill_n(pointer ptr, size_type n, value_type val) {
+        auto strategy = bulk::fill_strategy(n, val);
+        if(!use_thread_team(n)) {
+            bulk::fill(ptr, n, val, strategy);
+            return;
+        }
+        auto split = team_split(n, threading::transfer_settings().num_threads);
+        threading::for_each_chunk(split,
+            [ptr, val, strategy](size_type, Range r) {
+                bulk::fill(ptr+r.left(), r.size(), val, strategy);
+            });
+    }
 };
 
 } //namespace memory
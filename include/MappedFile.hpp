@@ -0,0 +1,259 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Allocator.hpp"
+#include "ArrayView.hpp"
+#include "definitions.hpp"
+#include "HostCoordinator.hpp"
+#include "util.hpp"
+
+namespace memory {
+
+// options for memory mapped files, which can be combined with |
+enum MapFlags : unsigned {
+    kMapDefault    = 0,
+    kMapPopulate   = 1,    // prefault the whole mapping (MAP_POPULATE)
+    kMapSequential = 2,    // expect sequential access (MADV_SEQUENTIAL)
+    kMapWillNeed   = 4     // start read-ahead immediately (MADV_WILLNEED)
+};
+
+namespace impl {
+namespace mapped {
+    constexpr size_type page_size = 4096;
+
+    // map bytes of the open file fd with the access pattern in flags
+    // returns nullptr on failure
+    static inline void* map_file(int fd, size_type bytes, unsigned flags) {
+        auto mmap_flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+        if(flags & kMapPopulate) {
+            mmap_flags |= MAP_POPULATE;
+        }
+#endif
+        void* ptr = mmap(nullptr, bytes, PROT_READ|PROT_WRITE, mmap_flags, fd, 0);
+        if(ptr == MAP_FAILED) {
+            std::cerr << util::red("error") << " memory:: unable to map "
+                      << bytes << " bytes of file" << std::endl;
+            return nullptr;
+        }
+
+        // the advice is only a hint, so failure is not an error
+        if(flags & kMapSequential) {
+            madvise(ptr, bytes, MADV_SEQUENTIAL);
+        }
+        if(flags & kMapWillNeed) {
+            madvise(ptr, bytes, MADV_WILLNEED);
+        }
+
+        return ptr;
+    }
+
+    // create an anonymous temporary file of bytes length in $TMPDIR (or /tmp)
+    // the file is unlinked straight away, so that it is removed by the
+    // operating system once it is unmapped
+    // returns -1 on failure
+    static inline int make_temp_file(size_type bytes) {
+        auto dir = std::getenv("TMPDIR");
+        std::string path = std::string(dir ? dir : "/tmp") + "/vector.XXXXXX";
+
+        int fd = mkstemp(&path[0]);
+        if(fd<0) {
+            std::cerr << util::red("error") << " memory:: unable to create "
+                      << "temporary file " << path << std::endl;
+            return -1;
+        }
+        unlink(path.c_str());
+
+        if(ftruncate(fd, bytes)) {
+            std::cerr << util::red("error") << " memory:: unable to resize "
+                      << "temporary file to " << bytes << " bytes" << std::endl;
+            close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+} // namespace mapped
+
+// Allocation policy that backs each block with a memory mapped temporary
+// file, so that arrays larger than physical memory can be used: the kernel
+// writes pages that do not fit in memory back to the file.
+// Flags is a combination of MapFlags that selects the access pattern.
+// Use MappedFile to map a named file.
+template <unsigned Flags>
+class MappedFilePolicy {
+public:
+    void *allocate_policy(size_type size) {
+        // mmap can't map zero bytes
+        auto bytes = size ? size : 1;
+
+        int fd = mapped::make_temp_file(bytes);
+        if(fd<0) {
+            return nullptr;
+        }
+
+        // the mapping keeps a reference to the file, which can be closed
+        void* ptr = mapped::map_file(fd, bytes, Flags);
+        close(fd);
+
+        if(ptr) {
+            registry().insert(ptr, {bytes, 0});
+        }
+        return ptr;
+    }
+
+    void free_policy(void *ptr) {
+        mapped::registry::record r;
+        if(ptr && registry().remove(ptr, r)) {
+            munmap(ptr, r.bytes);
+        }
+    }
+
+    static constexpr size_type alignment() {
+        return mapped::page_size;
+    }
+    static constexpr bool is_malloc_compatible() {
+        return true;
+    }
+
+private:
+    static mapped::registry& registry() {
+        static auto r = new mapped::registry();
+        return *r;
+    }
+};
+} // namespace impl
+
+namespace util {
+    template <unsigned Flags>
+    struct type_printer<impl::MappedFilePolicy<Flags>>{
+        static std::string print() {
+            std::stringstream str;
+            str << "MappedFilePolicy<" << Flags << ">";
+            return str.str();
+        }
+    };
+} // namespace util
+
+template <class T, unsigned Flags=kMapDefault>
+using MappedFileAllocator = Allocator<T, impl::MappedFilePolicy<Flags>>;
+
+// Maps a named file into memory, and gives access to its contents through
+// an ArrayView. Data written through the view is written to the file, and
+// mapping an existing file gives a view of the data in it without copying.
+//
+// If the file has fewer than n elements it is extended to n elements. If n
+// is zero the size is taken from the file.
+template <typename T, unsigned Flags=kMapDefault>
+class MappedFile {
+public:
+    using value_type       = T;
+    using size_type        = types::size_type;
+    using coordinator_type = HostCoordinator<T, MappedFileAllocator<T, Flags>>;
+    using view_type        = ArrayView<T, coordinator_type>;
+    using const_view_type  = ConstArrayView<T, coordinator_type>;
+
+    explicit MappedFile(std::string const& path, size_type n=0)
+    :   path_(path)
+    {
+        int fd = open(path.c_str(), O_RDWR|O_CREAT, 0644);
+        if(fd<0) {
+            std::cerr << util::red("error") << " memory:: unable to open "
+                      << path << std::endl;
+            return;
+        }
+
+        struct stat info;
+        if(fstat(fd, &info)) {
+            std::cerr << util::red("error") << " memory:: unable to stat "
+                      << path << std::endl;
+            close(fd);
+            return;
+        }
+
+        auto file_size = size_type(info.st_size)/sizeof(T);
+        if(n==0) {
+            n = file_size;
+        }
+        else if(file_size<n && ftruncate(fd, n*sizeof(T))) {
+            std::cerr << util::red("error") << " memory:: unable to resize "
+                      << path << " to " << n*sizeof(T) << " bytes" << std::endl;
+            close(fd);
+            return;
+        }
+
+        if(n>0) {
+            auto ptr = impl::mapped::map_file(fd, n*sizeof(T), Flags);
+            if(ptr) {
+                data_ = reinterpret_cast<T*>(ptr);
+                size_ = n;
+            }
+        }
+        close(fd);
+    }
+
+    MappedFile(MappedFile&& other)
+    :   path_(std::move(other.path_)), data_(other.data_), size_(other.size_)
+    {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    ~MappedFile() {
+        if(data_) {
+            munmap(data_, size_*sizeof(T));
+        }
+    }
+
+    // returns false if the file could not be mapped
+    bool is_open() const {
+        return data_ != nullptr;
+    }
+
+    // write modified pages back to the file, blocking until they are written
+    bool sync() {
+        return data_==nullptr || msync(data_, size_*sizeof(T), MS_SYNC)==0;
+    }
+
+    view_type view() {
+        return view_type(data_, size_);
+    }
+
+    const_view_type view() const {
+        return const_view_type(data_, size_);
+    }
+
+    T* data() {
+        return data_;
+    }
+
+    T const* data() const {
+        return data_;
+    }
+
+    size_type size() const {
+        return size_;
+    }
+
+    std::string const& path() const {
+        return path_;
+    }
+
+private:
+    std::string path_;
+    T* data_ = nullptr;
+    size_type size_ = 0;
+};
+
+} // namespace memory
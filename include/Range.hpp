@@ -30,9 +30,8 @@ public:
     {}
 
     //
-    // make Range compatible with TBB Range concept
+    // recursive splitting, used by threading::parallel_for, and by TBB
     //
-#ifdef USING_TBB
     bool empty() const {
         return right_==left_;
     }
@@ -41,13 +40,22 @@ public:
         return size()>1;
     }
 
-    Range(Range& other, tbb::split) {
-        auto m = (other.left() + other.right())/2;
-        left_ = m;
-        right_ = other.right();
-        other.set(other.left(), m);
+    // split at the midpoint m: keep [left, m) and return [m, right)
+    Range split() {
+        auto m = (left_ + right_)/2;
+        Range right(m, right_);
+        right_ = m;
+        return right;
     }
 
+    //
+    // make Range compatible with TBB Range concept
+    //
+#ifdef USING_TBB
+    Range(Range& other, tbb::split)
+    :   Range(other.split())
+    {}
+
     Range(Range& other, tbb::proportional_split p) {
         auto m = ((other.left()+other.right())*p.right())/(p.left()+p.right());
         if(m == 0) {
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+#include "Allocator.hpp"
+#include "definitions.hpp"
+#include "util.hpp"
+
+namespace memory {
+
+// A scratch memory space that hands out sub-blocks of one large slab by
+// incrementing a pointer, so that allocation of temporaries costs no more
+// than a pointer increment, and temporaries are packed next to each other.
+//
+// Memory is not freed individually. Instead a Scope records the top of the
+// arena when it is created, and releases everything allocated after that
+// when it is destroyed. Scopes can be nested.
+//
+// A Scope also makes its arena the current arena of the calling thread,
+// which is where ArenaAllocator allocates from, e.g.
+//
+//  ScratchArena arena(1<<30);
+//  for(auto step=0; step<num_steps; ++step) {
+//      ScratchArena::Scope scope(arena);
+//      Array<double, HostCoordinator<double, ArenaAllocator<double>>> tmp(n);
+//      ...
+//  } // tmp is released here
+class ScratchArena {
+public:
+    using size_type = types::size_type;
+
+    // the slab is aligned to a page boundary
+    static constexpr size_type slab_alignment = 4096;
+
+    class Scope {
+    public:
+        explicit Scope(ScratchArena& arena)
+        :   arena_(arena),
+            top_(arena.top_),
+            previous_(current())
+        {
+            current() = &arena;
+        }
+
+        ~Scope() {
+            arena_.top_ = top_;
+            current() = previous_;
+        }
+
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+
+    private:
+        ScratchArena& arena_;
+        size_type top_;
+        ScratchArena* previous_;
+    };
+
+    explicit ScratchArena(size_type capacity)
+    :   slab_(impl::aligned_malloc<char, slab_alignment>(capacity)),
+        capacity_(slab_ ? capacity : 0)
+    {
+        if(slab_ == nullptr) {
+            std::cerr << util::red("error") << " memory:: unable to allocate "
+                      << capacity << " bytes for scratch arena" << std::endl;
+        }
+    }
+
+    ~ScratchArena() {
+        free(slab_);
+    }
+
+    ScratchArena(ScratchArena const&) = delete;
+    ScratchArena& operator=(ScratchArena const&) = delete;
+
+    // returns a block of bytes aligned to alignment, which must be a power
+    // of two, or nullptr if there is not enough space left in the arena
+    void* allocate(size_type bytes, size_type alignment) {
+        auto base = reinterpret_cast<std::uintptr_t>(slab_);
+        auto first = (base+top_+alignment-1) & ~std::uintptr_t(alignment-1);
+        auto offset = size_type(first-base);
+        if(offset+bytes>capacity_) {
+            return nullptr;
+        }
+
+        top_ = offset+bytes;
+        if(top_>high_water_mark_) {
+            high_water_mark_ = top_;
+        }
+        return slab_+offset;
+    }
+
+    // the number of bytes currently allocated
+    size_type used() const {
+        return top_;
+    }
+
+    size_type capacity() const {
+        return capacity_;
+    }
+
+    // the largest number of bytes that have been allocated at one time
+    size_type high_water_mark() const {
+        return high_water_mark_;
+    }
+
+    void reset_high_water_mark() {
+        high_water_mark_ = top_;
+    }
+
+    // the arena of the innermost Scope on the calling thread, or nullptr
+    static ScratchArena*& current() {
+        static thread_local ScratchArena* arena = nullptr;
+        return arena;
+    }
+
+private:
+    char* slab_;
+    size_type capacity_;
+    size_type top_ = 0;
+    size_type high_water_mark_ = 0;
+};
+
+namespace impl {
+    // Allocation policy that allocates from the current ScratchArena of the
+    // calling thread, or from the arena it was constructed with. Freeing is a
+    // no-op: the memory is released when the ScratchArena::Scope in which it
+    // was allocated ends.
+    template <size_type Alignment>
+    class ArenaPolicy {
+        static_assert(is_power_of_two(Alignment),
+                "alignment is not a power of two");
+    public:
+        ArenaPolicy() = default;
+
+        // allocate from arena, on any thread
+        ArenaPolicy(ScratchArena& arena) : arena_(&arena) {}
+
+        void *allocate_policy(size_type size) {
+            auto arena = arena_ ? arena_ : ScratchArena::current();
+            if(arena == nullptr) {
+                std::cerr << util::red("error") << " memory:: ArenaPolicy "
+                          << "used outside of a ScratchArena::Scope" << std::endl;
+                return nullptr;
+            }
+
+            void* ptr = arena->allocate(size, Alignment);
+            if(ptr == nullptr) {
+                std::cerr << util::red("error") << " memory:: scratch arena "
+                          << "of " << arena->capacity() << " bytes is unable "
+                          << "to allocate " << size << " bytes" << std::endl;
+            }
+            return ptr;
+        }
+
+        void free_policy(void *) {}
+
+        static constexpr size_type alignment() {
+            return Alignment;
+        }
+        static constexpr bool is_malloc_compatible() {
+            return true;
+        }
+
+    private:
+        ScratchArena* arena_ = nullptr;
+    };
+} // namespace impl
+
+namespace util {
+    template <size_t Alignment>
+    struct type_printer<impl::ArenaPolicy<Alignment>>{
+        static std::string print() {
+            std::stringstream str;
+            str << "ArenaPolicy<" << Alignment << ">";
+            return str.str();
+        }
+    };
+} // namespace util
+
+template <class T, size_t alignment=impl::minimum_possible_alignment<T>()>
+using ArenaAllocator = Allocator<T, impl::ArenaPolicy<alignment>>;
+
+} // namespace memory
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <iterator>
 #include <ostream>
 
@@ -9,179 +10,268 @@
 
 namespace memory {
 
+namespace impl {
+    // the width of a cache line on the targets that we support
+    constexpr std::size_t cache_line_bytes = 64;
+} // namespace impl
+
+// The ways in which SplitRange can divide a range into chunks
+enum SplitMode {
+    // chunks of ceil(size/n) values, with a shorter last chunk, so that
+    // fewer than n chunks are made when n does not divide the range evenly,
+    // e.g. 10 into 4 makes 3,3,3,1 and 10 into 6 makes 2,2,2,2,2
+    kSplitStep,
+
+    // min(n, size) chunks that differ in size by at most one value,
+    // e.g. 10 into 4 makes 3,3,2,2
+    kSplitBalanced,
+
+    // like kSplitBalanced, over blocks of granularity values, so that every
+    // boundary between chunks is a multiple of granularity, e.g. so that
+    // threads writing to adjacent chunks of an array never write to the same
+    // cache line
+    kSplitAligned
+};
+
 class SplitRange {
   public:
     using size_type       = Range::size_type;
     using difference_type = Range::difference_type;
 
     // split range into n chunks
-    SplitRange(Range const& rng, size_type n) : range_(rng) {
+    SplitRange(Range const& rng, size_type n)
+    :   SplitRange(rng, n, kSplitStep)
+    {}
+
+    // split range into n chunks with mode, where the boundaries of chunks are
+    // multiples of granularity with kSplitAligned
+    SplitRange(Range const& rng, size_type n, SplitMode mode, size_type granularity=1)
+    :   range_(rng),
+        mode_(mode)
+    {
         // it makes no sense to break a range into 0 chunks
         assert(n>0);
+        assert(granularity>0);
+
+        if(mode_==kSplitStep) {
+            // add one to step_ if n does not evenly subdivide the target range
+            step_ = rng.size()/n + (rng.size()%n ? 1 : 0);
+            num_chunks_ = step_ ? (rng.size()+step_-1)/step_ : 0;
+            granularity_ = 1;
+            return;
+        }
+
+        // split the blocks [first_block_, last_block) that overlap the range
+        granularity_ = mode_==kSplitAligned ? granularity : 1;
+        first_block_ = rng.left()/granularity_;
+        auto last_block = (rng.right()+granularity_-1)/granularity_;
+        auto num_blocks = rng.size() ? last_block-first_block_ : 0;
+
+        num_chunks_ = std::min(n, num_blocks);
+        step_ = num_chunks_ ? num_blocks/num_chunks_ : 0;
+        remainder_ = num_chunks_ ? num_blocks%num_chunks_ : 0;
+    }
 
-        // add one to step_ if n does not evenly subdivide the target range
-        step_ = rng.size()/n + (rng.size()%n ? 1 : 0);
-    }
-
-    ///////////////////////////////////////////////////////////////////////////
-    // Iterator to generate a sequence of ranges that split the range into
-    // n disjoint sets
-    //
-    // Derived from input_iterator because it only makes sense to use as a read
-    // only iterator: the iterator does not refer to any external memory,
-    // instead returns to state that can only change when iterator is
-    // incremented via ++ operator
-    ///////////////////////////////////////////////////////////////////////////
-    class iterator
-      : public std::iterator<std::random_access_iterator_tag, Range>
-    {
-      public:
-          iterator(size_type first, size_type end, size_type step)
-              : range_(first, first+step),
-                step_(step),
-                begin_(first),
-                end_(end)
-          {
-              assert(first<=end);
-
-              if(range_.right()>end) {
-                  range_.set(first, end);
-              }
-          }
-
-          Range const& operator*() const {
-              return range_;
-          }
-
-          Range const* operator->() const {
-              return &range_;
-          }
-
-          iterator operator++(int) {
-              iterator previous(*this);
-              ++(*this);
-              return previous;
-          }
-
-          iterator operator--(int) {
-              iterator next(*this);
-              --(*this);
-              return next;
-          }
+    // random access iterator over the chunks, defined below
+    class iterator;
 
-          const iterator* operator++() {
-              size_type first = range_.left()+step_;
-              if(first>end_)
-                  first=end_;
+    iterator begin() const;
+    iterator end() const;
 
-              size_type last = range_.right()+step_;
-              if(last>end_)
-                  last=end_;
+    // the chunk with index i in [0, size())
+    Range operator [] (size_type i) const {
+        assert(i<num_chunks_);
 
-              // update range
-              range_.set(first, last);
+        if(mode_==kSplitStep) {
+            auto first = range_.left()+i*step_;
+            return Range(first, std::min(first+step_, range_.right()));
+        }
 
-              return this;
-          }
+        return Range(block_boundary(i), block_boundary(i+1));
+    }
 
-          const iterator* operator--() {
-              size_type first = range_.left()-step_;
-              if(first<begin_)
-                  first=begin_;
+    Range operator () (size_type i) const {
+        return (*this)[i];
+    }
 
-              size_type last = first+step_;
-              if(last>end_)
-                  last=end_;
+    // the number of chunks
+    size_type size() const {
+        return num_chunks_;
+    }
 
-              // update range
-              range_.set(first, last);
+    // the largest number of values in a chunk
+    size_type step_size() const {
+        if(mode_==kSplitStep) {
+            return step_;
+        }
+        return std::min((step_ + (remainder_ ? 1 : 0))*granularity_, range_.size());
+    }
 
-              return this;
-          }
+    Range range() const {
+        return range_;
+    }
 
-          const iterator* operator+=(int n) {
-              size_type first = range_.left()+step_*n;
-              if(first>end_)
-                  first=end_;
+    SplitMode mode() const {
+        return mode_;
+    }
+
+    size_type granularity() const {
+        return granularity_;
+    }
+
+  private:
+    // the first value of chunk i, where chunk i starts at the block
+    // i*step_ + min(i, remainder_) of the blocks that overlap the range
+    size_type block_boundary(size_type i) const {
+        if(i==0) {
+            return range_.left();
+        }
+        if(i==num_chunks_) {
+            return range_.right();
+        }
+        return (first_block_ + i*step_ + std::min(i, remainder_))*granularity_;
+    }
 
-              size_type last = first+step_;
-              if(last>end_)
-                  last=end_;
+    Range range_;
+    SplitMode mode_;
+    size_type step_;
+    size_type num_chunks_;
+    size_type granularity_;
+    size_type first_block_ = 0;
+    size_type remainder_ = 0;
+};
 
-              // update range
-              range_.set(first, last);
+///////////////////////////////////////////////////////////////////////////////
+// Iterator to generate the sequence of ranges that split the range into
+// disjoint sets
+//
+// The iterator holds the index of a chunk, and calculates the chunk from the
+// index, so it supports random access in constant time. It is a read only
+// iterator: it does not refer to any external memory, and the chunk it
+// returns is state that only changes when the iterator is moved.
+///////////////////////////////////////////////////////////////////////////////
+class SplitRange::iterator
+  : public std::iterator<std::random_access_iterator_tag, Range>
+{
+  public:
+    iterator(SplitRange const& split, size_type i)
+        : split_(split),
+          index_(i)
+    {
+        assert(i<=split.size());
+        update();
+    }
 
-              return this;
-          }
+    Range const& operator*() const {
+        return range_;
+    }
 
-          iterator operator+(int n) {
-              iterator i(*this);
-              i+=n;
-              return i;
-          }
+    Range const* operator->() const {
+        return &range_;
+    }
 
-          const iterator* operator-=(int n) {
-              size_type first = range_.left()+step_*n;
-              if(first<begin_)
-                  first=begin_;
+    Range operator[](difference_type n) const {
+        return split_[index_+n];
+    }
 
-              size_type last = first+step_;
-              if(last>end_)
-                  last=end_;
+    iterator operator++(int) {
+        iterator previous(*this);
+        ++(*this);
+        return previous;
+    }
 
-              // update range
-              range_.set(first, last);
+    iterator operator--(int) {
+        iterator next(*this);
+        --(*this);
+        return next;
+    }
 
-              return this;
-          }
+    iterator& operator++() {
+        return *this += 1;
+    }
 
-          iterator operator-(int n) {
-              iterator i(*this);
-              i-=n;
-              return i;
-          }
+    iterator& operator--() {
+        return *this -= 1;
+    }
 
-          bool operator == (const iterator& other) const {
-              return range_ == other.range_;
-          }
+    iterator& operator+=(difference_type n) {
+        index_ += n;
+        update();
+        return *this;
+    }
 
-          bool operator != (const iterator& other) const {
-              return range_ != other.range_;
-          }
+    iterator operator+(difference_type n) const {
+        iterator i(*this);
+        i+=n;
+        return i;
+    }
 
-      private:
-        Range range_;
-        size_type begin_;  // first value for begin_
-        size_type end_;    // final value for end
-        size_type step_;   // step by which range limits get increased
-    };
-    ///////////////////////////////////////
+    iterator& operator-=(difference_type n) {
+        return *this += -n;
+    }
 
-    iterator begin() const {
-        return iterator(range_.left(), range_.right(), step_);
+    iterator operator-(difference_type n) const {
+        iterator i(*this);
+        i-=n;
+        return i;
     }
 
-    iterator end() const {
-        return iterator(range_.right(), range_.right(), step_);
+    difference_type operator-(iterator const& other) const {
+        return difference_type(index_) - difference_type(other.index_);
     }
 
-    Range operator [] (int i) const {
-        return *(begin()+i);
+    bool operator == (const iterator& other) const {
+        return index_ == other.index_;
     }
 
-    size_type step_size() const {
-        return step_;
+    bool operator != (const iterator& other) const {
+        return index_ != other.index_;
     }
 
-    Range range() const {
-        return range_;
+    bool operator < (const iterator& other) const {
+        return index_ < other.index_;
     }
 
   private:
-    size_type step_;
-    Range range_;
+    // the end iterator refers to an empty range at the end of the split
+    void update() {
+        range_ = index_<split_.size()
+            ? split_[index_]
+            : Range(split_.range().right(), split_.range().right());
+    }
+
+    SplitRange split_;
+    size_type index_;   // index of the chunk
+    Range range_;       // the chunk
 };
 
+inline SplitRange::iterator SplitRange::begin() const {
+    return iterator(*this, 0);
+}
+
+inline SplitRange::iterator SplitRange::end() const {
+    return iterator(*this, size());
+}
+
+// split rng into n chunks whose boundaries are multiples of the number of
+// values of type T that fill a whole number of blocks of bytes bytes, e.g.
+// cache lines, or SIMD registers with bytes=32
+// the boundaries are aligned in memory if the value with index 0 is aligned
+template <typename T>
+SplitRange aligned_split(Range const& rng, Range::size_type n,
+                         Range::size_type bytes=impl::cache_line_bytes)
+{
+    // the smallest number of values that fill a whole number of blocks
+    auto a = bytes;
+    auto b = sizeof(T);
+    while(b) {
+        auto t = a%b;
+        a = b;
+        b = t;
+    }
+    return SplitRange(rng, n, kSplitAligned, bytes/a);
+}
+
 // overload output operator for split range
 static std::ostream& operator << (std::ostream& os, const SplitRange& split) {
     os << "(" << split.range() << " by " << split.step_size() << ")";
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "Array.hpp"
+#include "definitions.hpp"
+#include "HostCoordinator.hpp"
+#include "Range.hpp"
+
+namespace memory {
+
+namespace impl {
+    // copy from into to with the coordinator of to
+    // the coordinator is called directly, because assigning an ArrayReference
+    // to another of the same type rebinds it instead of copying the values
+    template <typename From, typename To>
+    void staged_hop(From&& from, To to) {
+        typename To::coordinator_type().copy(from, to);
+    }
+} // namespace impl
+
+// Copy from into to, which may be managed by any two coordinators, through
+// a ring of n_buffers staging buffers of chunk_bytes bytes each.
+//
+// The copy is split into chunks, and each chunk is copied in two hops:
+// from -> staging buffer, by a helper thread, then staging buffer -> to, by
+// the calling thread. The first hop of the next chunks overlaps with the
+// second hop of the current chunk, so the time of the copy approaches the
+// time of the slower hop, instead of the sum of both, e.g. reading from a
+// memory mapped file while writing to HBW memory, or reading pageable host
+// memory while writing to a device.
+//
+// Each hop is performed by the coordinator of the memory written to, so the
+// staging coordinator must be able to copy from from, and the coordinator
+// of to must be able to copy from the staging memory. Use a staging
+// coordinator with pinned memory for transfers to and from a GPU.
+//
+// Returns when the copy is complete.
+template <
+    typename FromView,
+    typename ToView,
+    typename StagingCoord
+        = HostCoordinator<typename std::decay<FromView>::type::value_type>
+>
+void staged_copy(FromView&& from, ToView&& to,
+                 types::size_type chunk_bytes = types::size_type(1)<<22,
+                 unsigned n_buffers = 2)
+{
+    using value_type = typename std::decay<FromView>::type::value_type;
+    using size_type = types::size_type;
+    using staging_type = Array<value_type, StagingCoord>;
+
+    assert(from.size()==to.size());
+    assert(n_buffers>0);
+
+    auto n = from.size();
+    auto chunk = std::max(chunk_bytes/sizeof(value_type), size_type(1));
+    auto num_chunks = (n+chunk-1)/chunk;
+    if(num_chunks==0) {
+        return;
+    }
+
+    n_buffers = std::min<size_type>(n_buffers, num_chunks);
+    staging_type staging(n_buffers*chunk);
+    auto chunk_range = [chunk, n](size_type i) {
+        return Range(i*chunk, std::min((i+1)*chunk, n));
+    };
+    auto buffer_range = [chunk](size_type i, size_type len, unsigned n_buffers) {
+        auto first = (i%n_buffers)*chunk;
+        return Range(first, first+len);
+    };
+
+    // with one buffer there is nothing to overlap
+    if(n_buffers==1) {
+        for(auto i=size_type(0); i<num_chunks; ++i) {
+            auto r = chunk_range(i);
+            auto b = buffer_range(i, r.size(), 1);
+            impl::staged_hop(from(r), staging(b));
+            impl::staged_hop(staging(b), to(r));
+        }
+        return;
+    }
+
+    // the number of chunks that have been copied into, and out of, the ring
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_type filled = 0;
+    size_type drained = 0;
+
+    std::thread producer([&] {
+        for(auto i=size_type(0); i<num_chunks; ++i) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] {return i-drained<n_buffers;});
+            }
+            auto r = chunk_range(i);
+            impl::staged_hop(from(r), staging(buffer_range(i, r.size(), n_buffers)));
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++filled;
+            }
+            changed.notify_all();
+        }
+    });
+
+    for(auto i=size_type(0); i<num_chunks; ++i) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] {return filled>i;});
+        }
+        auto r = chunk_range(i);
+        impl::staged_hop(staging(buffer_range(i, r.size(), n_buffers)), to(r));
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++drained;
+        }
+        changed.notify_all();
+    }
+
+    producer.join();
+}
+
+} // namespace memory
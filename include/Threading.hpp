@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "definitions.hpp"
+#include "Range.hpp"
+#include "SplitRange.hpp"
+
+namespace memory {
+namespace threading {
+
+// returns the number of hardware threads, or 1 if it can't be determined
+static inline unsigned hardware_threads() {
+    auto n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+// Settings for splitting large host memory transfers (HostCoordinator::copy
+// and HostCoordinator::set) across a team of threads.
+// Transfers are serial by default: set num_threads to enable the thread team.
+struct TransferSettings {
+    // the number of threads that share a transfer
+    unsigned num_threads = 1;
+
+    // transfers smaller than this many bytes are always serial
+    types::size_type parallel_threshold = types::size_type(1)<<25;
+
+    // the number of background threads that perform asynchronous transfers
+    // (HostCoordinator::copy_async and HostCoordinator::set_async)
+    // this is read once, when the first asynchronous transfer is made
+    unsigned num_async_threads = 1;
+};
+
+// the settings shared by all translation units
+inline TransferSettings& transfer_settings() {
+    static TransferSettings settings;
+    return settings;
+}
+
+namespace impl {
+    // the cpus on which the calling thread may run, in increasing order,
+    // or an empty list if they can't be determined
+    inline std::vector<int> allowed_cpus() {
+        std::vector<int> cpus;
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if(sched_getaffinity(0, sizeof(set), &set)==0) {
+            for(auto cpu=0; cpu<CPU_SETSIZE; ++cpu) {
+                if(CPU_ISSET(cpu, &set)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+#endif
+        return cpus;
+    }
+
+    // bind the calling thread to cpu, where possible
+    inline void pin_this_thread(int cpu) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+    }
+
+    // the chunks of split, in order
+    template <typename Split>
+    std::vector<Range> chunks(Split const& split) {
+        std::vector<Range> ranges;
+        for(auto r: split) {
+            ranges.push_back(r);
+        }
+        return ranges;
+    }
+} // namespace impl
+
+// Call f(i, r) for every chunk r of split, where i is the index of the chunk,
+// and return when all chunks are finished.
+// The chunks are shared by a team of at most hardware_threads() threads,
+// including the calling thread, with chunk i processed by thread i%team size.
+//
+// The threads of the team are started on every call, and are not bound to
+// cores, so use first_touch() to place pages.
+//
+// split can be any iterable set of ranges, e.g. a SplitRange,
+// WeightedSplitRange or AdaptiveSplitRange.
+template <typename Split, typename F>
+void for_each_chunk(Split const& split, F&& f) {
+    auto chunks = impl::chunks(split);
+    auto n = chunks.size();
+    auto team = std::min<types::size_type>(n, hardware_threads());
+
+    auto work = [&f, &chunks, n, team](types::size_type t) {
+        for(auto i=t; i<n; i+=team) {
+            f(i, chunks[i]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(auto t=types::size_type(1); t<team; ++t) {
+        threads.emplace_back(work, t);
+    }
+    if(team>0) {
+        work(0);
+    }
+    for(auto& t: threads) {
+        t.join();
+    }
+}
+
+// Call f(i, r) for every chunk r of split, where i is the index of the chunk,
+// on threads that are bound to cores, so that under a first-touch page
+// placement policy the pages of each chunk of an array are placed in memory
+// local to the core that will later process the chunk.
+//
+// With OpenMP the chunks are processed in a parallel region, with chunk i
+// processed by thread i%num_threads of the team, so the places of the team
+// (e.g. OMP_PROC_BIND=close OMP_PLACES=cores) decide where pages go. The
+// loops that process the array should use the same binding, and a static
+// schedule with one chunk of the array per thread.
+//
+// Without OpenMP the chunks are processed by a team of threads, with at most
+// one thread per cpu that the caller may run on. The team is spread evenly
+// over those cpus, so that thread t of a team of size T is bound to cpu
+// t*(C/T) of the C allowed cpus, and a small team is not packed onto the
+// first node. Chunk i is processed by thread i%T. The loops that process the
+// array should bind their threads in the same order.
+template <typename Split, typename F>
+void first_touch(Split const& split, F&& f) {
+    auto chunks = impl::chunks(split);
+    auto n = chunks.size();
+    if(n==0) {
+        return;
+    }
+
+#ifdef _OPENMP
+    auto team = int(std::min<types::size_type>(n, omp_get_max_threads()));
+    #pragma omp parallel num_threads(team) if(team>1)
+    {
+        auto t = types::size_type(omp_get_thread_num());
+        auto num_threads = types::size_type(omp_get_num_threads());
+        for(auto i=t; i<n; i+=num_threads) {
+            f(i, chunks[i]);
+        }
+    }
+#else
+    auto cpus = impl::allowed_cpus();
+    if(cpus.empty()) {
+        for_each_chunk(chunks, f);
+        return;
+    }
+
+    auto team = std::min<types::size_type>(n, cpus.size());
+    auto stride = cpus.size()/team;
+    std::vector<std::thread> threads;
+    for(auto t=types::size_type(0); t<team; ++t) {
+        auto cpu = cpus[t*stride];
+        threads.emplace_back([&f, &chunks, n, team, t, cpu] {
+            // bind before touching any memory
+            impl::pin_this_thread(cpu);
+            for(auto i=t; i<n; i+=team) {
+                f(i, chunks[i]);
+            }
+        });
+    }
+    for(auto& t: threads) {
+        t.join();
+    }
+#endif
+}
+
+// A fixed team of background threads that run tasks in the order in which
+// they are enqueued. Tasks still in the queue when the pool is destroyed are
+// run before the threads are joined.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned num_threads) {
+        num_threads = num_threads ? num_threads : 1;
+        for(auto i=0u; i<num_threads; ++i) {
+            threads_.emplace_back([this] {work();});
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        available_.notify_all();
+        for(auto& t: threads_) {
+            t.join();
+        }
+    }
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    void enqueue(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        available_.notify_one();
+    }
+
+    unsigned size() const {
+        return threads_.size();
+    }
+
+private:
+    void work() {
+        while(true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                available_.wait(lock, [this] {return stop_ || !tasks_.empty();});
+                if(tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> threads_;
+    bool stop_ = false;
+};
+
+// the pool that performs asynchronous transfers, which is started on first
+// use with transfer_settings().num_async_threads threads
+inline ThreadPool& async_pool() {
+    static ThreadPool pool(transfer_settings().num_async_threads);
+    return pool;
+}
+
+} // namespace threading
+} // namespace memory
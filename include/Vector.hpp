@@ -4,7 +4,9 @@
 
 #include "Array.hpp"
 #include "definitions.hpp"
+#include "EmulatedDeviceCoordinator.hpp"
 #include "HostCoordinator.hpp"
+#include "MappedFile.hpp"
 
 #ifdef WITH_CUDA
 #include "DeviceCoordinator.hpp"
@@ -28,6 +30,37 @@ std::ostream& operator<< (std::ostream& o, HostView<T> const& v) {
     return o;
 }
 
+// specialization for host vectors padded to a multiple of the SIMD width
+template <typename T>
+using PaddedVector = Array<T, HostCoordinator<T, PaddedAllocator<T>>>;
+template <typename T>
+using PaddedView = ArrayView<T, HostCoordinator<T, PaddedAllocator<T>>>;
+
+// specialization for host vectors backed by huge pages
+template <typename T>
+using HugePageVector = Array<T, HostCoordinator<T, HugePageAllocator<T>>>;
+template <typename T>
+using HugePageView = ArrayView<T, HostCoordinator<T, HugePageAllocator<T>>>;
+
+// returns the kind of pages that were obtained for a huge page vector
+template <typename T>
+PageBacking page_backing(HugePageView<T> const& v) {
+    return HugePageAllocator<T>::backing(v.data());
+}
+
+// specialization for host vectors backed by memory mapped temporary files
+template <typename T>
+using MappedVector = Array<T, HostCoordinator<T, MappedFileAllocator<T>>>;
+template <typename T>
+using MappedView = ArrayView<T, HostCoordinator<T, MappedFileAllocator<T>>>;
+
+// specialization for emulated device memory, which is host memory that is
+// accessed and transferred like device memory
+template <typename T>
+using EmulatedDeviceVector = Array<T, EmulatedDeviceCoordinator<T>>;
+template <typename T>
+using EmulatedDeviceView = ArrayView<T, EmulatedDeviceCoordinator<T>>;
+
 #ifdef WITH_CUDA
 // specialization for pinned vectors. Use a host_coordinator, because memory is
 // in the host memory space, and all of the helpers (copy, set, etc) are the
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include <cassert>
+
+#include "Array.hpp"
+#include "definitions.hpp"
+#include "Range.hpp"
+#include "SplitRange.hpp"
+#include "Threading.hpp"
+
+namespace memory {
+
+// Splits a range into n chunks of roughly equal total cost, given the cost
+// of every element, for loops where the work per element is uneven, e.g.
+//
+//  HostVector<double> cost = ...;
+//  auto split = WeightedSplitRange(Range(0, n), num_threads, cost);
+//
+//  #pragma omp parallel
+//  {
+//      auto range = split(omp_get_thread_num());
+//      ...
+//  }
+//
+// Chunk k ends at the element where the prefix sum of the costs is closest
+// to k/n of the total cost. A single element that costs more than a chunk
+// is not split, so some chunks can be empty, but there are always n chunks.
+// With zero total cost the range is split into balanced chunks of elements.
+//
+// The prefix sum is calculated in parallel, by the thread team in
+// threading::transfer_settings(), when the costs take at least
+// parallel_threshold bytes.
+class WeightedSplitRange {
+  public:
+    using size_type       = Range::size_type;
+    using difference_type = Range::difference_type;
+    using cost_type       = double;
+
+    using iterator = std::vector<Range>::const_iterator;
+
+    // split rng into n chunks, where costs[i] is the cost of element i
+    // costs must be in host memory, and cover rng
+    template <
+        typename Costs,
+        typename = typename std::enable_if<impl::is_array<Costs>::value>::type
+    >
+    WeightedSplitRange(Range const& rng, size_type n, Costs const& costs)
+    :   range_(rng)
+    {
+        // it makes no sense to break a range into 0 chunks
+        assert(n>0);
+        assert(costs.size()>=rng.right());
+
+        auto prefix = prefix_sum(costs.data()+rng.left(), rng.size());
+        auto total = prefix.back();
+
+        if(!(total>0)) {
+            SplitRange balanced(rng, n, kSplitBalanced);
+            chunks_.assign(balanced.begin(), balanced.end());
+            chunks_.resize(n, Range(rng.right(), rng.right()));
+            return;
+        }
+
+        chunks_.reserve(n);
+        auto first = rng.left();
+        for(auto k=size_type(1); k<=n; ++k) {
+            auto last = k==n ? rng.right()
+                             : rng.left()+boundary(prefix, k*total/n);
+            last = std::max(first, last);
+            chunks_.push_back(Range(first, last));
+            first = last;
+        }
+    }
+
+    iterator begin() const {
+        return chunks_.begin();
+    }
+
+    iterator end() const {
+        return chunks_.end();
+    }
+
+    // the chunk with index i in [0, size())
+    Range operator [] (size_type i) const {
+        assert(i<size());
+        return chunks_[i];
+    }
+
+    Range operator () (size_type i) const {
+        return (*this)[i];
+    }
+
+    // the number of chunks
+    size_type size() const {
+        return chunks_.size();
+    }
+
+    Range range() const {
+        return range_;
+    }
+
+  private:
+    // the index b in [0, m] for which prefix[b] is closest to target, where
+    // prefix[b] is the cost of the first b elements
+    static size_type boundary(std::vector<cost_type> const& prefix, cost_type target) {
+        auto it = std::lower_bound(prefix.begin(), prefix.end(), target);
+        if(it==prefix.end()) {
+            --it;
+        }
+        else if(it!=prefix.begin() && target-*(it-1) < *it-target) {
+            --it;
+        }
+        return it-prefix.begin();
+    }
+
+    // the exclusive prefix sum of the m costs in costs, with the total at the
+    // end, so that element i of the result is the cost of the first i elements
+    template <typename T>
+    static std::vector<cost_type> prefix_sum(T const* costs, size_type m) {
+        std::vector<cost_type> prefix(m+1);
+        prefix[0] = 0;
+
+        auto const& settings = threading::transfer_settings();
+        if(settings.num_threads<2 || m*sizeof(T)<settings.parallel_threshold) {
+            for(auto i=size_type(0); i<m; ++i) {
+                prefix[i+1] = prefix[i] + cost_type(costs[i]);
+            }
+            return prefix;
+        }
+
+        // each thread sums its chunk, the chunk totals are scanned, then each
+        // thread writes the prefix sum of its chunk from the chunk offset
+        SplitRange split(Range(0, m), settings.num_threads, kSplitBalanced);
+        std::vector<cost_type> offsets(split.size()+1, 0);
+        threading::for_each_chunk(split,
+            [costs, &offsets](size_type i, Range r) {
+                cost_type sum = 0;
+                for(auto j: r) {
+                    sum += cost_type(costs[j]);
+                }
+                offsets[i+1] = sum;
+            });
+        for(auto i=size_type(1); i<offsets.size(); ++i) {
+            offsets[i] += offsets[i-1];
+        }
+        threading::for_each_chunk(split,
+            [costs, &offsets, &prefix](size_type i, Range r) {
+                auto sum = offsets[i];
+                for(auto j: r) {
+                    sum += cost_type(costs[j]);
+                    prefix[j+1] = sum;
+                }
+            });
+        return prefix;
+    }
+
+    Range range_;
+    std::vector<Range> chunks_;
+};
+
+// overload output operator for weighted split range
+inline std::ostream& operator << (std::ostream& os, const WeightedSplitRange& split) {
+    os << "(" << split.range() << " in " << split.size() << " weighted chunks)";
+    return os;
+}
+
+} // namespace memory
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cassert>
+
+#include "definitions.hpp"
+#include "Range.hpp"
+#include "Threading.hpp"
+
+namespace memory {
+namespace threading {
+
+// A team of background threads that run tasks by work stealing, used by
+// parallel_for, so that parallel loops behave the same with every
+// compiler, without OpenMP or TBB.
+//
+// Each thread has its own queue of tasks: it runs the tasks it enqueued most
+// recently first, and when its queue is empty it steals the oldest tasks
+// from the queues of other threads. Tasks enqueued by threads outside the
+// pool go to a shared queue, from which the pool threads take work.
+//
+// A thread that waits for tasks, in TaskGroup::wait(), runs tasks while it
+// waits instead of blocking. Parallel loops nested in the tasks of another
+// loop, and recursive kernels, are run by the threads of the pool instead of
+// starting more threads, so they don't oversubscribe the cores.
+class WorkStealingPool {
+public:
+    // start num_threads background threads
+    // the threads that wait on TaskGroups also run tasks, so a pool with
+    // no background threads runs every task on the waiting thread
+    explicit WorkStealingPool(unsigned num_threads) {
+        // one queue per thread, and the shared queue at the end
+        for(auto i=0u; i<=num_threads; ++i) {
+            queues_.emplace_back(new queue);
+        }
+        for(auto i=0u; i<num_threads; ++i) {
+            threads_.emplace_back([this, i] {work(i);});
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for(auto& t: threads_) {
+            t.join();
+        }
+    }
+
+    WorkStealingPool(WorkStealingPool const&) = delete;
+    WorkStealingPool& operator=(WorkStealingPool const&) = delete;
+
+    // add task to the queue of the calling thread, or to the shared queue
+    // if the calling thread is not in the pool
+    void enqueue(std::function<void()> task) {
+        auto& q = *queues_[this_queue()];
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.tasks.push_back(std::move(task));
+        }
+        ++num_queued_;
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+        }
+        wake_.notify_one();
+    }
+
+    // run one task, taken from the queue of the calling thread, the shared
+    // queue, or another thread, in that order
+    // returns false if there were no tasks
+    bool run_one() {
+        std::function<void()> task;
+        if(!take(task)) {
+            return false;
+        }
+        task();
+        return true;
+    }
+
+    // the number of background threads
+    unsigned size() const {
+        return threads_.size();
+    }
+
+private:
+    struct queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // the pool and queue of the calling thread, if it is in a pool
+    struct worker_id {
+        WorkStealingPool const* pool;
+        unsigned index;
+    };
+
+    static worker_id& this_worker() {
+        static thread_local worker_id id{nullptr, 0};
+        return id;
+    }
+
+    unsigned this_queue() const {
+        auto const& id = this_worker();
+        return id.pool==this ? id.index : size();
+    }
+
+    bool take(std::function<void()>& task) {
+        if(num_queued_==0) {
+            return false;
+        }
+
+        // newest task in our own queue, then oldest in the others, starting
+        // with the shared queue
+        auto n = unsigned(queues_.size());
+        auto self = this_queue();
+        for(auto i=0u; i<n; ++i) {
+            auto index = (self+n-i)%n;
+            auto& q = *queues_[index];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if(q.tasks.empty()) {
+                continue;
+            }
+            if(index==self) {
+                task = std::move(q.tasks.back());
+                q.tasks.pop_back();
+            }
+            else {
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+            }
+            --num_queued_;
+            return true;
+        }
+        return false;
+    }
+
+    void work(unsigned index) {
+        this_worker() = worker_id{this, index};
+        while(true) {
+            if(run_one()) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            wake_.wait(lock, [this] {return stop_ || num_queued_>0;});
+            if(stop_ && num_queued_==0) {
+                return;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<types::size_type> num_queued_{0};
+
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+};
+
+// A set of tasks run by a WorkStealingPool, that can be waited on.
+// The group must be waited on before it is destroyed, which the destructor
+// does if it was not.
+class TaskGroup {
+public:
+    explicit TaskGroup(WorkStealingPool& pool)
+    :   pool_(pool)
+    {}
+
+    ~TaskGroup() {
+        wait();
+    }
+
+    TaskGroup(TaskGroup const&) = delete;
+    TaskGroup& operator=(TaskGroup const&) = delete;
+
+    // add f to the group, to be run by the pool
+    void run(std::function<void()> f) {
+        ++pending_;
+        pool_.enqueue([this, f] {
+            f();
+            --pending_;
+        });
+    }
+
+    // run tasks of the pool until every task in the group has finished
+    void wait() {
+        while(pending_>0) {
+            if(!pool_.run_one()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    WorkStealingPool& pool_;
+    std::atomic<types::size_type> pending_{0};
+};
+
+// the pool used by parallel_for, which is started on first use with one
+// thread fewer than the hardware threads, because the calling thread also
+// runs tasks
+inline WorkStealingPool& work_stealing_pool() {
+    static WorkStealingPool pool(hardware_threads()-1);
+    return pool;
+}
+
+namespace impl {
+    template <typename F>
+    void parallel_for(TaskGroup& group, Range r, types::size_type grain, F const& f) {
+        // hand the right halves to the pool, and keep the left half
+        while(r.size()>grain && r.is_divisible()) {
+            auto right = r.split();
+            group.run([&group, right, grain, &f] {
+                parallel_for(group, right, grain, f);
+            });
+        }
+        if(!r.empty()) {
+            f(r);
+        }
+    }
+} // namespace impl
+
+// Call f(r) on sub-ranges r of rng with at most grain values, that cover rng,
+// in parallel on the threads of pool and the calling thread.
+// The sub-ranges are made by recursively splitting rng at the midpoint, the
+// same as the TBB splitting constructor of Range, so they are the same on
+// every platform.
+// Returns when f has been called on every sub-range. f may itself call
+// parallel_for.
+template <typename F>
+void parallel_for(WorkStealingPool& pool, Range const& rng,
+                  types::size_type grain, F&& f)
+{
+    assert(grain>0);
+    TaskGroup group(pool);
+    impl::parallel_for(group, rng, grain, f);
+    group.wait();
+}
+
+template <typename F>
+void parallel_for(Range const& rng, types::size_type grain, F&& f) {
+    parallel_for(work_stealing_pool(), rng, grain, std::forward<F>(f));
+}
+
+} // namespace threading
+} // namespace memory
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <sstream>
+#include <type_traits>
 
 namespace memory {
 
@@ -10,6 +11,36 @@ namespace types {
     typedef std::size_t     size_type;
 } // namespace types
 
+namespace impl {
+    // Holds a value of type T, e.g. the allocator of a coordinator or the
+    // coordinator of a view. Empty types are held as a base class, so that
+    // they take no space in the class that derives from ebo_storage (the empty
+    // base optimisation), and stateless views are just a pointer and a size.
+    // Tag is the deriving class, so that a class can have more than one.
+    template <typename T, typename Tag, bool = std::is_empty<T>::value>
+    class ebo_storage : private T {
+    public:
+        ebo_storage() = default;
+        explicit ebo_storage(T const& value) : T(value) {}
+
+        T& get() { return *this; }
+        T const& get() const { return *this; }
+    };
+
+    template <typename T, typename Tag>
+    class ebo_storage<T, Tag, false> {
+    public:
+        ebo_storage() = default;
+        explicit ebo_storage(T const& value) : value_(value) {}
+
+        T& get() { return value_; }
+        T const& get() const { return value_; }
+
+    private:
+        T value_;
+    };
+} // namespace impl
+
 namespace util {
 
     // forward declare type printer
@@ -0,0 +1,154 @@
+#include "gtest.h"
+#include "split_checks.hpp"
+
+#include <vector>
+
+#include <AdaptiveSplitRange.hpp>
+#include <Threading.hpp>
+
+using memory_test::check_cover;
+
+// the first split is balanced
+TEST(AdaptiveSplitRange, initial) {
+    using namespace memory;
+
+    AdaptiveSplitRange split(Range(0, 10), 4);
+    std::vector<Range> expected = {{0, 3}, {3, 6}, {6, 8}, {8, 10}};
+    EXPECT_EQ(expected, std::vector<Range>(split.begin(), split.end()));
+    EXPECT_EQ(split[1], split(1));
+
+    // nothing has been recorded
+    EXPECT_EQ(1., split.imbalance());
+}
+
+// chunks on slow cores shrink until the times are equal
+TEST(AdaptiveSplitRange, converge) {
+    using namespace memory;
+
+    const auto n = 10000u;
+    // the seconds per element of four cores, where core 1 is 3 times slower
+    std::vector<double> cost = {1e-9, 3e-9, 1e-9, 1e-9};
+    AdaptiveSplitRange split(Range(0, n), cost.size());
+
+    auto record = [&] {
+        for(auto i=0u; i<split.size(); ++i) {
+            split.record(i, split[i].size()*cost[i]);
+        }
+    };
+
+    record();
+    EXPECT_NEAR(2., split.imbalance(), 1e-6);
+
+    for(auto step=0; step<20; ++step) {
+        split.rebalance();
+        check_cover(split, Range(0, n));
+        record();
+    }
+    EXPECT_LT(split.imbalance(), 1.01);
+
+    // the fast cores take 3/10 of the range each
+    EXPECT_NEAR(1000., split[1].size(), 20.);
+    EXPECT_NEAR(3000., split[0].size(), 20.);
+    EXPECT_EQ(split.size(), split.times().size());
+}
+
+// chunks that are not recorded keep their last speed, or run at the mean
+// speed of the others if they have never been recorded
+TEST(AdaptiveSplitRange, partial_record) {
+    using namespace memory;
+
+    const auto n = 1000u;
+    AdaptiveSplitRange split(Range(0, n), 4, 1.);
+    auto sizes = [&] {
+        std::vector<std::size_t> s;
+        for(auto r: split) {
+            s.push_back(r.size());
+        }
+        return s;
+    };
+
+    // only two chunks are recorded on the first call, at the same speed
+    split.record(0, 250e-9);
+    split.record(2, 250e-9);
+    EXPECT_EQ(0., split.times()[1]);
+    split.rebalance();
+    EXPECT_EQ(std::vector<std::size_t>({250, 250, 250, 250}), sizes());
+    EXPECT_EQ(250e-9, split.last_times()[0]);
+    EXPECT_EQ(0., split.last_times()[1]);
+
+    // the times are consumed by rebalance
+    for(auto t: split.times()) {
+        EXPECT_EQ(0., t);
+    }
+    EXPECT_EQ(1., split.imbalance());
+
+    // chunk 3 is three times slower
+    split.record(0, 250e-9);
+    split.record(1, 250e-9);
+    split.record(2, 250e-9);
+    split.record(3, 750e-9);
+    split.rebalance();
+    EXPECT_EQ(std::vector<std::size_t>({300, 300, 300, 100}), sizes());
+
+    // chunk 3 is not recorded, so it keeps its speed
+    split.record(0, 300e-9);
+    split.record(1, 300e-9);
+    split.record(2, 300e-9);
+    EXPECT_EQ(0., split.times()[3]);
+    split.rebalance();
+    EXPECT_EQ(std::vector<std::size_t>({300, 300, 300, 100}), sizes());
+    check_cover(split, Range(0, n));
+}
+
+// every chunk keeps an element while there are enough, so it can be timed
+TEST(AdaptiveSplitRange, min_size) {
+    using namespace memory;
+
+    AdaptiveSplitRange split(Range(5, 25), 4, 1.);
+    split.record(0, 1.);
+    split.record(1, 1e-9);
+    split.record(2, 1e-9);
+    split.record(3, 1e-9);
+    split.rebalance();
+
+    check_cover(split, Range(5, 25));
+    for(auto r: split) {
+        EXPECT_LE(1u, r.size());
+    }
+    EXPECT_EQ(1u, split[0].size());
+
+    // fewer elements than chunks
+    AdaptiveSplitRange small(Range(0, 2), 4);
+    small.record(0, 1.);
+    small.rebalance();
+    check_cover(small, Range(0, 2));
+}
+
+// the chunks can be processed and timed by the thread team
+TEST(AdaptiveSplitRange, for_each_chunk) {
+    using namespace memory;
+
+    const auto n = 1000u;
+    std::vector<int> v(n, 0);
+    AdaptiveSplitRange split(Range(0, n), 3);
+
+    for(auto step=0; step<3; ++step) {
+        threading::for_each_chunk(split,
+            [&](std::size_t i, Range) {
+                split.timed(i, [&](Range r) {
+                    for(auto j: r) {
+                        v[j]++;
+                    }
+                });
+            });
+        for(auto t: split.times()) {
+            EXPECT_LT(0., t);
+        }
+        split.rebalance();
+        check_cover(split, Range(0, n));
+    }
+
+    for(auto x: v) {
+        EXPECT_EQ(3, x);
+    }
+}
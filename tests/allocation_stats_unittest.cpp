@@ -0,0 +1,136 @@
+#include "gtest.h"
+
+#include <sstream>
+
+#include <AllocationStats.hpp>
+#include <Vector.hpp>
+
+namespace {
+    struct test_space {};
+
+    memory::stats::counters find(memory::stats::report_type const& r,
+                                 std::string const& name)
+    {
+        for(auto const& entry: r)
+            if(entry.first==name)
+                return entry.second;
+        return memory::stats::counters();
+    }
+}
+
+namespace memory {
+namespace util {
+    template <>
+    struct type_printer<test_space>{
+        static std::string print() {
+            return std::string("test_space");
+        }
+    };
+}
+}
+
+// test that counters are kept per memory space and per tag
+TEST(AllocationStats, counters) {
+    using namespace memory;
+
+    stats::reset();
+
+    int a, b, c;
+    {
+        stats::ScopedTag tag("outer");
+        stats::record_allocate<test_space>(&a, 100);
+        {
+            stats::ScopedTag inner("inner");
+            stats::record_allocate<test_space>(&b, 1000);
+        }
+        stats::record_allocate<test_space>(&c, 100);
+    }
+    stats::record_free(&b);
+    stats::record_free(&a);
+
+    auto space = find(stats::spaces(), "test_space");
+    EXPECT_EQ(100u,  space.live_bytes);
+    EXPECT_EQ(1200u, space.peak_bytes);
+    EXPECT_EQ(3u,    space.allocations);
+    EXPECT_EQ(2u,    space.frees);
+    EXPECT_EQ(2u,    space.histogram[7]);  // 100 bytes <= 128
+    EXPECT_EQ(1u,    space.histogram[10]); // 1000 bytes <= 1024
+
+    auto outer = find(stats::tags(), "outer");
+    EXPECT_EQ(100u, outer.live_bytes);
+    EXPECT_EQ(200u, outer.peak_bytes);
+    EXPECT_EQ(2u,   outer.allocations);
+
+    auto inner = find(stats::tags(), "inner");
+    EXPECT_EQ(0u,    inner.live_bytes);
+    EXPECT_EQ(1000u, inner.peak_bytes);
+
+    // frees of memory that was not recorded are ignored
+    stats::record_free(&space);
+    EXPECT_EQ(100u, find(stats::spaces(), "test_space").live_bytes);
+
+    stats::reset();
+    EXPECT_EQ(0u, find(stats::spaces(), "test_space").allocations);
+    EXPECT_EQ(0u, stats::tags().size());
+}
+
+// test that coordinators record allocations when statistics are enabled
+TEST(AllocationStats, coordinator) {
+    using namespace memory;
+
+    stats::reset();
+    {
+        stats::ScopedTag tag("vectors");
+        HostVector<double> v(128);
+    }
+
+    auto vectors = find(stats::tags(), "vectors");
+    if(stats::enabled()) {
+        EXPECT_EQ(1u, vectors.allocations);
+        EXPECT_EQ(1u, vectors.frees);
+        EXPECT_EQ(1024u, vectors.peak_bytes);
+    }
+    else {
+        EXPECT_EQ(0u, vectors.allocations);
+    }
+
+    std::stringstream s;
+    stats::report(s);
+    EXPECT_FALSE(s.str().empty());
+}
+
+// test that memory spaces are named by the allocation policy, and shared by
+// every element type allocated with that policy
+TEST(AllocationStats, spaces_by_policy) {
+    using namespace memory;
+
+    using aligned_policy = impl::AlignedPolicy<64>;
+    using pool_policy    = impl::PoolPolicy<64>;
+
+    stats::reset();
+    {
+        Array<double, HostCoordinator<double, AlignedAllocator<double, 64>>> a(10);
+        Array<float,  HostCoordinator<float,  AlignedAllocator<float, 64>>>  b(10);
+        Array<double, HostCoordinator<double, PoolAllocator<double, 64>>>    c(10);
+    }
+
+    auto count = [] (std::string const& name) {
+        auto n = 0;
+        for(auto const& entry: stats::spaces())
+            n += entry.first==name;
+        return n;
+    };
+    auto aligned_name = util::type_printer<aligned_policy>::print();
+    auto pool_name    = util::type_printer<pool_policy>::print();
+    EXPECT_NE(aligned_name, pool_name);
+
+    if(stats::enabled()) {
+        EXPECT_EQ(1, count(aligned_name));
+        EXPECT_EQ(1, count(pool_name));
+        EXPECT_EQ(2u, find(stats::spaces(), aligned_name).allocations);
+        EXPECT_EQ(1u, find(stats::spaces(), pool_name).allocations);
+    }
+    else {
+        EXPECT_EQ(0, count(aligned_name));
+    }
+}
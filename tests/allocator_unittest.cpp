@@ -1,5 +1,9 @@
 #include "gtest.h"
 
+#include <cstdint>
+#include <thread>
+#include <vector>
+
 #include <Allocator.hpp>
 #include <HostCoordinator.hpp>
 
@@ -96,3 +100,94 @@ TEST(Allocator, padding) {
     EXPECT_EQ( get_padding<double>(64, 7), 1 );
     EXPECT_EQ( get_padding<double>(64, 8), 0 );
 }
+
+TEST(Allocator, pool_policy) {
+    using namespace memory;
+    using policy = impl::PoolPolicy<64>;
+    using allocator = Allocator<double, policy>;
+
+    policy::release();
+    allocator alloc;
+
+    // blocks are aligned, and freed blocks are cached rather than released
+    auto p1 = alloc.allocate(100);
+    EXPECT_NE(p1, nullptr);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p1)%64, 0u);
+    EXPECT_EQ(policy::cached_bytes(), 0u);
+    alloc.deallocate(p1, 100);
+    EXPECT_EQ(policy::cached_bytes(), 1024u);
+
+    // a request in the same size class reuses the cached block
+    auto p2 = alloc.allocate(120);
+    EXPECT_EQ(p1, p2);
+    EXPECT_EQ(policy::cached_bytes(), 0u);
+
+    // a request in a different size class gets a new block
+    auto p3 = alloc.allocate(10);
+    EXPECT_NE(p2, p3);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p3)%64, 0u);
+
+    alloc.deallocate(p2, 120);
+    alloc.deallocate(p3, 10);
+    EXPECT_EQ(policy::cached_bytes(), 1024u+128u);
+
+    policy::release();
+    EXPECT_EQ(policy::cached_bytes(), 0u);
+}
+
+TEST(Allocator, pool_policy_unpooled) {
+    using namespace memory;
+    using policy = impl::PoolPolicy<16, 256>;
+    using allocator = Allocator<char, policy>;
+
+    allocator alloc;
+
+    // blocks larger than the maximum block size bypass the pool
+    auto p = alloc.allocate(1000);
+    EXPECT_NE(p, nullptr);
+    alloc.deallocate(p, 1000);
+    EXPECT_EQ(policy::cached_bytes(), 0u);
+}
+
+TEST(Allocator, thread_cache_policy) {
+    using namespace memory;
+    using policy = impl::ThreadCachePolicy<impl::AlignedPolicy<64>, 4096>;
+    using allocator = Allocator<double, policy>;
+
+    allocator alloc;
+
+    // freed blocks are cached by the thread and reused
+    auto p1 = alloc.allocate(100);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p1)%64, 0u);
+    alloc.deallocate(p1, 100);
+    EXPECT_EQ(policy::cached_bytes(), 1024u);
+    auto p2 = alloc.allocate(128);
+    EXPECT_EQ(p1, p2);
+    EXPECT_EQ(policy::cached_bytes(), 0u);
+
+    // blocks are not shared with other threads
+    std::thread([&] {
+        auto p = alloc.allocate(100);
+        EXPECT_NE(p, p2);
+        alloc.deallocate(p, 100);
+        EXPECT_EQ(policy::cached_bytes(), 1024u);
+    }).join();
+    EXPECT_EQ(policy::cached_bytes(), 0u);
+
+    // the cache size is bounded
+    std::vector<double*> blocks;
+    for(auto i=0; i<8; ++i)
+        blocks.push_back(alloc.allocate(128));
+    for(auto p: blocks)
+        alloc.deallocate(p, 128);
+    EXPECT_EQ(policy::cached_bytes(), 4096u);
+
+    // blocks larger than the cache are never cached
+    auto big = alloc.allocate(1024);
+    alloc.deallocate(big, 1024);
+    EXPECT_EQ(policy::cached_bytes(), 4096u);
+
+    alloc.deallocate(p2, 128);
+    policy::flush();
+    EXPECT_EQ(policy::cached_bytes(), 0u);
+}
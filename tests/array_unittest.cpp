@@ -1,6 +1,8 @@
 #include "gtest.h"
+#include "counting_policy.hpp"
 
 #include <Array.hpp>
+#include <ArrayGroup.hpp>
 #include <HostCoordinator.hpp>
 
 // verify that metafunctions for checking range wrappers work
@@ -160,3 +162,88 @@ TEST(Array, assignment) {
     for(auto value: v)
         EXPECT_EQ(value, 3.14);
 }
+
+// test that an Array allocates and frees with its own coordinator instance,
+// and that the coordinator follows the memory on copy and move
+TEST(Array, stateful_coordinator) {
+    using namespace memory;
+    using namespace memory_test;
+
+    using alloc_t = Allocator<int, CountingPolicy>;
+    using coord_t = HostCoordinator<int, alloc_t>;
+    using array_t = Array<int, coord_t>;
+
+    counting_heap heap_a, heap_b;
+    coord_t coord_a{alloc_t(heap_a)};
+    coord_t coord_b{alloc_t(heap_b)};
+
+    {
+        array_t a(10, 1, coord_a);
+        EXPECT_EQ(1u, heap_a.allocations);
+        EXPECT_EQ(10*sizeof(int), heap_a.live);
+
+        // copy construction uses the coordinator of the source
+        array_t b(a);
+        EXPECT_EQ(2u, heap_a.allocations);
+        EXPECT_EQ(1, b[9]);
+
+        // move construction takes the memory and the coordinator
+        array_t c(std::move(b));
+        EXPECT_EQ(2u, heap_a.allocations);
+
+        // copy assignment keeps the coordinator of the destination
+        array_t d(10, coord_b);
+        EXPECT_EQ(1u, heap_b.allocations);
+        d = a;
+        EXPECT_EQ(2u, heap_b.allocations);
+        EXPECT_EQ(10*sizeof(int), heap_b.live);
+        EXPECT_EQ(1, d[0]);
+
+        // move assignment swaps memory and coordinators, so each block is
+        // freed by the coordinator that allocated it
+        array_t e(20, 2, coord_b);
+        EXPECT_EQ(30*sizeof(int), heap_b.live);
+        c = std::move(e);
+        EXPECT_EQ(2, c[19]);
+    }
+    EXPECT_EQ(0u, heap_a.live);
+    EXPECT_EQ(0u, heap_b.live);
+
+    // first-touch and parallel-fill arrays use the coordinator
+    {
+        array_t f(10, SplitRange(Range(0, 10), 2), coord_a);
+        array_t g(20, 5, parallel_fill, 2, coord_a);
+        EXPECT_EQ(30*sizeof(int), heap_a.live);
+        EXPECT_EQ(5, g[19]);
+    }
+    EXPECT_EQ(0u, heap_a.live);
+
+    // stateless coordinators add no storage to an Array, which is a pointer
+    // and a size like a view, while stateful coordinators are stored
+    static_assert(sizeof(Array<int, HostCoordinator<int>>)==2*sizeof(void*),
+                  "Array with a stateless coordinator should be two words");
+    EXPECT_LT(sizeof(Array<int, HostCoordinator<int>>), sizeof(array_t));
+}
+
+// test that a group allocates and frees with its own coordinator instance
+TEST(Array, stateful_group) {
+    using namespace memory;
+    using namespace memory_test;
+
+    using alloc_t = Allocator<float, CountingPolicy>;
+    using coord_t = HostCoordinator<float, alloc_t>;
+
+    counting_heap heap;
+    {
+        ArrayGroup<float, coord_t> arrays(100, 3, 64, coord_t(alloc_t(heap)));
+        EXPECT_EQ(1u, heap.allocations);
+        EXPECT_EQ(1u, heap.sizes.size());
+        arrays[2](all) = 1.f;
+
+        // the coordinator moves with the memory
+        auto moved = std::move(arrays);
+        EXPECT_EQ(1.f, moved[2][99]);
+    }
+    EXPECT_EQ(0u, heap.live);
+    EXPECT_TRUE(heap.sizes.empty());
+}
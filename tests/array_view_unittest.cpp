@@ -1,5 +1,8 @@
 #include "gtest.h"
 
+#include <numeric>
+
+#include <ScratchArena.hpp>
 #include <Vector.hpp>
 
 // check that const views work
@@ -71,3 +74,35 @@ TEST(array_view, const_members) {
         auto view2 = a.const_data_view();
     }
 }
+
+// views with stateless coordinators are a pointer and a size, so that they
+// are passed to functions in registers, while a coordinator with state is
+// stored in the view
+TEST(array_view, compact) {
+    using namespace memory;
+
+    using host_coord = HostCoordinator<double>;
+    using emulated_coord = EmulatedDeviceCoordinator<double>;
+
+    static_assert(sizeof(ArrayView<double, host_coord>)==2*sizeof(void*),
+                  "views should be two words");
+    static_assert(sizeof(ConstArrayView<double, host_coord>)==2*sizeof(void*),
+                  "const views should be two words");
+    static_assert(sizeof(ArrayReference<double, host_coord>)==2*sizeof(void*),
+                  "references should be two words");
+    static_assert(sizeof(ArrayView<double, emulated_coord>)==2*sizeof(void*),
+                  "emulated device views should be two words");
+    static_assert(std::is_trivially_copyable<ArrayView<double, host_coord>>::value,
+                  "views should be trivially copyable");
+
+    using arena_coord = HostCoordinator<double, ArenaAllocator<double>>;
+    ScratchArena arena(1<<12);
+    arena_coord coord{ArenaAllocator<double>(arena)};
+    EXPECT_EQ(3*sizeof(void*), sizeof(ArrayView<double, arena_coord>));
+
+    Array<double, arena_coord> a(8, 1., coord);
+    EXPECT_EQ(8*sizeof(double), arena.used());
+    a(0, 4) = 2.;
+    EXPECT_EQ(2., a[3]);
+    EXPECT_EQ(1., a[4]);
+}
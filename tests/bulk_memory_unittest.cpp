@@ -0,0 +1,99 @@
+#include "gtest.h"
+
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <BulkMemory.hpp>
+
+namespace {
+    // force the non-temporal tier for the lifetime of the object
+    struct force_nontemporal {
+        force_nontemporal()
+        :   threshold_(memory::bulk::settings().nontemporal_threshold)
+        {
+            memory::bulk::settings().nontemporal_threshold = 0;
+        }
+        ~force_nontemporal() {
+            memory::bulk::settings().nontemporal_threshold = threshold_;
+        }
+        memory::types::size_type threshold_;
+    };
+
+    struct triple {
+        float x, y, z;
+    };
+}
+
+TEST(BulkMemory, strategy) {
+    using namespace memory::bulk;
+
+    EXPECT_EQ(kBulkElementwise, copy_strategy<std::string>(10));
+    EXPECT_EQ(kBulkMemory, copy_strategy<double>(10));
+
+    EXPECT_EQ(kBulkMemory, fill_strategy<double>(10, 0.));
+    EXPECT_EQ(kBulkMemory, fill_strategy<int>(10, -1));
+    EXPECT_EQ(kBulkPattern, fill_strategy<double>(10, 1.));
+    EXPECT_EQ(kBulkElementwise, fill_strategy<std::string>(10, "a"));
+
+    if(have_nontemporal_stores()) {
+        force_nontemporal force;
+        EXPECT_EQ(kBulkNonTemporal, copy_strategy<double>(10));
+        EXPECT_EQ(kBulkNonTemporal, fill_strategy<double>(10, 1.));
+        // the size of triple does not divide the vector width
+        EXPECT_EQ(kBulkPattern, fill_strategy<triple>(10, triple{1,2,3}));
+    }
+}
+
+// copy every strategy with unaligned heads and tails
+TEST(BulkMemory, copy) {
+    using namespace memory::bulk;
+
+    const size_t n = 1000;
+    std::vector<int> from(n+8);
+    std::iota(from.begin(), from.end(), 0);
+
+    for(auto s: {kBulkElementwise, kBulkMemory, kBulkNonTemporal}) {
+        for(auto offset=0u; offset<8u; ++offset) {
+            for(auto len: {size_t(0), size_t(3), n-offset}) {
+                std::vector<int> to(n+8, -1);
+                copy(from.data(), len, to.data()+offset, s);
+                for(auto i=0u; i<to.size(); ++i) {
+                    auto expected = i>=offset && i<offset+len ? int(i-offset) : -1;
+                    EXPECT_EQ(expected, to[i]);
+                }
+            }
+        }
+    }
+}
+
+TEST(BulkMemory, fill) {
+    using namespace memory::bulk;
+
+    const size_t n = 1000;
+    for(auto s: {kBulkElementwise, kBulkMemory, kBulkPattern, kBulkNonTemporal}) {
+        for(auto offset=0u; offset<8u; ++offset) {
+            std::vector<double> v(n+8, 1.);
+            fill(v.data()+offset, n-offset, 0., s);
+            for(auto i=0u; i<v.size(); ++i) {
+                EXPECT_EQ(i>=offset && i<n ? 0. : 1., v[i]);
+            }
+        }
+    }
+
+    // non-uniform byte patterns through the default strategy
+    force_nontemporal force;
+    for(auto offset=0u; offset<8u; ++offset) {
+        std::vector<double> v(n, 0.);
+        fill(v.data()+offset, n-offset, 3.5);
+        for(auto i=0u; i<n; ++i) {
+            EXPECT_EQ(i>=offset ? 3.5 : 0., v[i]);
+        }
+
+        std::vector<triple> t(n, triple{0,0,0});
+        fill(t.data()+offset, n-offset, triple{1,2,3});
+        for(auto i=0u; i<n; ++i) {
+            EXPECT_EQ(i>=offset ? 2.f : 0.f, t[i].y);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#include "gtest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+#include <Calibration.hpp>
+
+TEST(Calibration, save_load) {
+    using namespace memory::calibration;
+
+    // a temporary file, which is removed at the end of the test
+    char name[] = "/tmp/calibration_unittestXXXXXX";
+    auto fd = mkstemp(name);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    std::string path = name;
+
+    Result r;
+    r.nontemporal_threshold = 123456;
+    r.parallel_threshold = never;
+    r.num_threads = 7;
+    EXPECT_TRUE(save(r, path));
+
+    Result loaded;
+    EXPECT_TRUE(load(path, loaded));
+    EXPECT_EQ(r.nontemporal_threshold, loaded.nontemporal_threshold);
+    EXPECT_EQ(r.parallel_threshold, loaded.parallel_threshold);
+    EXPECT_EQ(r.num_threads, loaded.num_threads);
+
+    // results saved on another CPU model are ignored
+    {
+        std::ofstream file(path);
+        file << "cpu another cpu\n" << r;
+    }
+    EXPECT_FALSE(load(path, loaded));
+
+    std::remove(path.c_str());
+    EXPECT_FALSE(load(path, loaded));
+}
+
+TEST(Calibration, measure) {
+    using namespace memory;
+    using namespace memory::calibration;
+
+    auto r = measure(1<<20);
+    EXPECT_GT(r.nontemporal_threshold, 0u);
+    EXPECT_GT(r.parallel_threshold, 0u);
+    EXPECT_GE(r.num_threads, 1u);
+    if(r.parallel_threshold==never) {
+        EXPECT_EQ(1u, r.num_threads);
+    }
+
+    auto nontemporal = bulk::settings().nontemporal_threshold;
+    auto transfer = threading::transfer_settings();
+
+    apply(r);
+    EXPECT_EQ(r.nontemporal_threshold, bulk::settings().nontemporal_threshold);
+    EXPECT_EQ(r.parallel_threshold, threading::transfer_settings().parallel_threshold);
+    EXPECT_EQ(r.num_threads, threading::transfer_settings().num_threads);
+
+    bulk::settings().nontemporal_threshold = nontemporal;
+    threading::transfer_settings() = transfer;
+}
@@ -0,0 +1,116 @@
+#include "gtest.h"
+
+#include <thread>
+#include <vector>
+
+#include <ChunkDispenser.hpp>
+
+namespace {
+    // take every chunk of chunks on num_threads threads, and count the
+    // number of times each value of [0, n) is visited
+    std::vector<int> visit(memory::ChunkDispenser& chunks, std::size_t n) {
+        std::vector<int> counts(n, 0);
+        std::vector<std::thread> threads;
+        for(auto t=0u; t<chunks.num_threads(); ++t) {
+            threads.emplace_back([&chunks, &counts, t] {
+                memory::Range r;
+                while(chunks.next(r, t)) {
+                    for(auto i: r) {
+                        counts[i]++;
+                    }
+                }
+            });
+        }
+        for(auto& t: threads) {
+            t.join();
+        }
+        return counts;
+    }
+}
+
+TEST(ChunkDispenser, dynamic) {
+    using namespace memory;
+
+    ChunkDispenser chunks(Range(10, 110), 8);
+    EXPECT_EQ(kDispenseDynamic, chunks.mode());
+
+    std::vector<Range> taken;
+    Range r;
+    while(chunks.next(r)) {
+        taken.push_back(r);
+    }
+    EXPECT_EQ(13u, taken.size());
+    EXPECT_EQ(Range(10, 18), taken.front());
+    EXPECT_EQ(Range(106, 110), taken.back());
+    EXPECT_EQ(13u, chunks.chunks_taken(0));
+
+    // the chunk is unchanged when the range is finished
+    EXPECT_FALSE(chunks.next(r));
+    EXPECT_EQ(Range(106, 110), r);
+}
+
+// the cursor is on its own cache line
+static_assert(alignof(memory::ChunkDispenser)==memory::impl::cache_line_bytes,
+              "the cursor of a ChunkDispenser should be aligned to a cache line");
+static_assert(sizeof(memory::ChunkDispenser)%memory::impl::cache_line_bytes==0,
+              "a ChunkDispenser should fill whole cache lines");
+
+// guided chunks shrink to the grain
+TEST(ChunkDispenser, guided) {
+    using namespace memory;
+
+    ChunkDispenser chunks(Range(0, 1000), 10, kDispenseGuided, 4);
+
+    std::vector<Range> taken;
+    Range r;
+    while(chunks.next(r, 2)) {
+        taken.push_back(r);
+    }
+    EXPECT_EQ(Range(0, 250), taken.front());
+    EXPECT_EQ(1000u, taken.back().right());
+    for(auto i=1u; i<taken.size(); ++i) {
+        EXPECT_EQ(taken[i-1].right(), taken[i].left());
+        EXPECT_LE(taken[i].size(), taken[i-1].size());
+        if(i+1<taken.size()) {
+            EXPECT_LE(10u, taken[i].size());
+        }
+    }
+    EXPECT_EQ(taken.size(), chunks.chunks_taken(2));
+    EXPECT_EQ(0u, chunks.chunks_taken(0));
+}
+
+// every value is handed out once to threads that share the dispenser, and
+// the dispenser can be reset and reused
+TEST(ChunkDispenser, threads) {
+    using namespace memory;
+
+    const auto n = 100000u;
+    for(auto mode: {kDispenseDynamic, kDispenseGuided}) {
+        ChunkDispenser chunks(Range(0, n), 16, mode, 4);
+
+        for(auto iteration=0; iteration<3; ++iteration) {
+            chunks.reset();
+            EXPECT_EQ(0u, chunks.chunks_taken());
+
+            for(auto c: visit(chunks, n)) {
+                EXPECT_EQ(1, c);
+            }
+
+            auto total = 0u;
+            for(auto t=0u; t<chunks.num_threads(); ++t) {
+                total += chunks.chunks_taken(t);
+            }
+            EXPECT_EQ(total, chunks.chunks_taken());
+            if(mode==kDispenseDynamic) {
+                EXPECT_EQ(n/16, total);
+            }
+        }
+    }
+
+    // reset with a new range
+    ChunkDispenser chunks(Range(0, 10), 4);
+    chunks.reset(Range(20, 30));
+    Range r;
+    EXPECT_TRUE(chunks.next(r));
+    EXPECT_EQ(Range(20, 24), r);
+}
@@ -0,0 +1,79 @@
+#include "gtest.h"
+
+#include <numeric>
+#include <vector>
+
+#include <CopyBatch.hpp>
+#include <HostCoordinator.hpp>
+#include <Vector.hpp>
+
+// copies that are contiguous in source and destination are merged
+TEST(CopyBatch, coalesce) {
+    using namespace memory;
+
+    std::vector<int> from(100), to(100);
+    CopyBatch<int> batch;
+    EXPECT_EQ(0u, batch.size());
+
+    // added out of order, with the last two not contiguous in to
+    batch.add(from.data()+10, to.data()+10, 10);
+    batch.add(from.data()+0,  to.data()+0,  10);
+    batch.add(from.data()+20, to.data()+20, 5);
+    batch.add(from.data()+25, to.data()+50, 5);
+    batch.add(from.data()+90, to.data()+90, 0);
+
+    EXPECT_EQ(4u, batch.num_copies());
+    EXPECT_EQ(30u, batch.size());
+
+    auto const& s = batch.segments();
+    ASSERT_EQ(2u, s.size());
+    EXPECT_EQ(from.data(), s[0].from);
+    EXPECT_EQ(to.data(), s[0].to);
+    EXPECT_EQ(25u, s[0].size);
+    EXPECT_EQ(from.data()+25, s[1].from);
+    EXPECT_EQ(5u, s[1].size);
+
+    // sub-ranges that span segments
+    std::vector<CopyBatch<int>::segment> parts;
+    batch.for_each_segment(Range(20, 28),
+        [&parts](CopyBatch<int>::segment const& p) {parts.push_back(p);});
+    ASSERT_EQ(2u, parts.size());
+    EXPECT_EQ(from.data()+20, parts[0].from);
+    EXPECT_EQ(5u, parts[0].size);
+    EXPECT_EQ(to.data()+50, parts[1].to);
+    EXPECT_EQ(3u, parts[1].size);
+
+    batch.clear();
+    EXPECT_EQ(0u, batch.size());
+    EXPECT_EQ(0u, batch.num_copies());
+}
+
+// a halo exchange style batch performed by the host coordinator, with and
+// without the thread team
+TEST(CopyBatch, host_coordinator) {
+    using namespace memory;
+
+    const size_t n = 1000;
+    HostVector<int> field(2*n, -1);
+    std::iota(field.begin(), field.begin()+n, 0);
+
+    // copy the first half to the second half in blocks of 7
+    CopyBatch<int> batch;
+    for(auto i=0u; i<n; i+=7) {
+        auto last = std::min(i+7, unsigned(n));
+        batch.add(field(i, last), field(n+i, n+last));
+    }
+    EXPECT_EQ(1u, batch.segments().size());
+
+    auto saved = threading::transfer_settings();
+    for(auto threads: {1u, 3u}) {
+        threading::transfer_settings().num_threads = threads;
+        threading::transfer_settings().parallel_threshold = 0;
+
+        field(n, end) = -1;
+        HostCoordinator<int>().copy_batch(batch);
+        for(auto i=0u; i<n; ++i)
+            EXPECT_EQ(int(i), field[n+i]);
+    }
+    threading::transfer_settings() = saved;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdlib>
+#include <map>
+
+#include "gtest.h"
+
+// An allocation policy for tests of stateful coordinators, which counts the
+// allocations made from each instance.
+namespace memory_test {
+    // the memory allocated from a CountingPolicy, with the size of each block
+    struct counting_heap {
+        std::size_t live = 0;
+        std::size_t allocations = 0;
+        std::map<void*, std::size_t> sizes;
+    };
+
+    class CountingPolicy {
+    public:
+        CountingPolicy() = default;
+        CountingPolicy(counting_heap& heap) : heap_(&heap) {}
+
+        void* allocate_policy(std::size_t size) {
+            auto ptr = std::malloc(size);
+            if(heap_) {
+                heap_->live += size;
+                heap_->allocations++;
+                heap_->sizes[ptr] = size;
+            }
+            return ptr;
+        }
+
+        void free_policy(void* ptr) {
+            if(heap_ && ptr) {
+                // memory allocated by another heap would not be found
+                auto it = heap_->sizes.find(ptr);
+                EXPECT_TRUE(it!=heap_->sizes.end());
+                if(it!=heap_->sizes.end()) {
+                    heap_->live -= it->second;
+                    heap_->sizes.erase(it);
+                }
+            }
+            std::free(ptr);
+        }
+
+        static constexpr std::size_t alignment() {
+            return sizeof(void*);
+        }
+        static constexpr bool is_malloc_compatible() {
+            return true;
+        }
+
+    private:
+        counting_heap* heap_ = nullptr;
+    };
+} // namespace memory_test
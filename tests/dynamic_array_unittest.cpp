@@ -0,0 +1,123 @@
+#include "gtest.h"
+#include "counting_policy.hpp"
+
+#include <DynamicArray.hpp>
+#include <Vector.hpp>
+
+// test growth of small arrays allocated by the coordinator
+TEST(DynamicArray, push_back) {
+    using namespace memory;
+
+    DynamicArray<int> a;
+    EXPECT_EQ(0u, a.size());
+    EXPECT_EQ(0u, a.capacity());
+
+    for(auto i=0; i<100; ++i) {
+        a.push_back(i);
+        EXPECT_GE(a.capacity(), a.size());
+    }
+    EXPECT_EQ(100u, a.size());
+    EXPECT_EQ(128u, a.capacity());
+    EXPECT_FALSE(a.is_mapped());
+    for(auto i: a.range())
+        EXPECT_EQ(int(i), a[i]);
+
+    // sub-ranges are views, as for Array
+    auto view = a(10, 20);
+    EXPECT_EQ(10u, view.size());
+    EXPECT_EQ(10, view[0]);
+
+    a.pop_back();
+    EXPECT_EQ(99u, a.size());
+    a.clear();
+    EXPECT_EQ(0u, a.size());
+    EXPECT_EQ(128u, a.capacity());
+}
+
+// test resize and reserve
+TEST(DynamicArray, resize) {
+    using namespace memory;
+
+    DynamicArray<double> a(10, 1.);
+    a.resize(20, 2.);
+    EXPECT_EQ(20u, a.size());
+    EXPECT_EQ(1., a[9]);
+    EXPECT_EQ(2., a[10]);
+
+    a.reserve(1000);
+    EXPECT_EQ(1000u, a.capacity());
+    EXPECT_EQ(20u, a.size());
+    EXPECT_EQ(2., a[19]);
+
+    a.resize(5);
+    EXPECT_EQ(5u, a.size());
+    EXPECT_EQ(1000u, a.capacity());
+}
+
+// test that large arrays are mapped and grown in place with mremap
+TEST(DynamicArray, mapped_growth) {
+    using namespace memory;
+    using array = DynamicArray<double>;
+
+    const size_t n = array::remap_threshold/sizeof(double);
+
+    array a;
+    for(size_t i=0; i<4*n; ++i)
+        a.push_back(double(i));
+
+    EXPECT_TRUE(a.is_mapped());
+    EXPECT_EQ(4*n, a.size());
+    for(auto i: {size_t(0), n-1, n, 2*n+1, 4*n-1})
+        EXPECT_EQ(double(i), a[i]);
+
+    // copies and moves
+    array b(a);
+    EXPECT_NE(a.data(), b.data());
+    EXPECT_EQ(4*n, b.size());
+    EXPECT_EQ(double(4*n-1), b[4*n-1]);
+
+    auto ptr = b.data();
+    array c(std::move(b));
+    EXPECT_EQ(ptr, c.data());
+    EXPECT_EQ(0u, b.size());
+    EXPECT_TRUE(c.is_mapped());
+
+    // copy into an Array
+    HostVector<double> v(c);
+    EXPECT_EQ(c.size(), v.size());
+    EXPECT_EQ(double(n), v[n]);
+}
+
+// test that large arrays with a policy other than the default aligned policy
+// are allocated by the coordinator of the array, not mapped
+TEST(DynamicArray, coordinator_growth) {
+    using namespace memory;
+    using namespace memory_test;
+
+    using alloc_t = Allocator<double, CountingPolicy>;
+    using coord_t = HostCoordinator<double, alloc_t>;
+    using array = DynamicArray<double, coord_t>;
+    static_assert(!array::remappable, "only the default policy is remapped");
+    static_assert(DynamicArray<double>::remappable, "the default policy is remapped");
+
+    const size_t n = 2*array::remap_threshold/sizeof(double);
+
+    counting_heap heap;
+    {
+        array a{coord_t(alloc_t(heap))};
+        for(size_t i=0; i<n; ++i)
+            a.push_back(double(i));
+
+        EXPECT_FALSE(a.is_mapped());
+        EXPECT_EQ(1u, heap.sizes.size());
+        EXPECT_EQ(a.capacity()*sizeof(double), heap.sizes.begin()->second);
+        EXPECT_EQ(double(n-1), a[n-1]);
+
+        // copies take the coordinator of the source
+        array b(a);
+        EXPECT_EQ(2u, heap.sizes.size());
+    }
+    EXPECT_EQ(0u, heap.live);
+    EXPECT_TRUE(heap.sizes.empty());
+    EXPECT_LT(0u, heap.allocations);
+}
@@ -0,0 +1,160 @@
+#include "gtest.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+
+#include <EmulatedDeviceCoordinator.hpp>
+#include <HostCoordinator.hpp>
+
+// verify that type members set correctly
+TEST(EmulatedDeviceCoordinator, type_members) {
+    using namespace memory;
+
+    typedef EmulatedDeviceCoordinator<int> intcoord_t;
+
+    // verify that the correct type is used for internal storage
+    ::testing::StaticAssertTypeEq<int,   intcoord_t::value_type>();
+    ::testing::StaticAssertTypeEq<double,intcoord_t::rebind<double>::value_type>();
+}
+
+// test allocation of base arrays
+TEST(EmulatedDeviceCoordinator, arraybase_alloc_free) {
+    using namespace memory;
+
+    typedef EmulatedDeviceCoordinator<int> intcoord_t;
+    intcoord_t coordinator;
+
+    auto array = coordinator.allocate(5);
+    typedef decltype(array) arr_t;
+
+    EXPECT_TRUE(impl::is_array_view<arr_t>::value);
+    EXPECT_NE(arr_t::pointer(0), array.data());
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(array.data())%256);
+
+    coordinator.free(array);
+
+    EXPECT_EQ(arr_t::pointer(0), array.data());
+    EXPECT_EQ(arr_t::size_type(0), array.size());
+}
+
+// test copies between host and device, and within the device
+TEST(EmulatedDeviceCoordinator, copy_synchronous) {
+    using namespace memory;
+
+    const int N = 100;
+
+    typedef double T;
+    typedef EmulatedDeviceCoordinator<T> dc_t;
+    typedef HostCoordinator<T>   hc_t;
+    typedef ArrayView<T, dc_t> da_t;
+    typedef ArrayView<T, hc_t> ha_t;
+
+    ha_t host_array(hc_t().allocate(N));
+    ha_t host_result(hc_t().allocate(N));
+    da_t device_array(dc_t().allocate(N));
+    da_t device_other(dc_t().allocate(N));
+
+    for(auto i: Range(0,N))
+        host_array[i] = T(i);
+
+    // host to device
+    auto event = dc_t().copy(host_array, device_array);
+    EXPECT_EQ(kEventReady, event.first.query());
+    for(auto i: Range(0,N))
+        EXPECT_EQ(host_array[i], T(device_array[i]));
+
+    // device to device, and device to host through the host coordinator
+    dc_t().copy(device_array, device_other);
+    hc_t().copy(device_other, host_result);
+    for(auto i: Range(0,N))
+        EXPECT_EQ(host_array[i], host_result[i]);
+
+    // set is queued on the default stream, and element access waits for it
+    dc_t().set(device_array, -1.);
+    for(auto i: Range(0,N))
+        EXPECT_EQ(-1., T(device_array[i]));
+
+    device_array[3] = 4.;
+    EXPECT_EQ(4., T(device_array[3]));
+
+    hc_t().free(host_array);
+    hc_t().free(host_result);
+    dc_t().free(device_array);
+    dc_t().free(device_other);
+}
+
+// test that copies on a stream are performed in order, and that events
+// become ready when the work before them has finished
+TEST(EmulatedDeviceCoordinator, copy_asynchronous) {
+    using namespace memory;
+
+    const int N = 1000;
+
+    typedef int T;
+    typedef EmulatedDeviceCoordinator<T> dc_t;
+    typedef HostCoordinator<T>   hc_t;
+    typedef ArrayView<T, dc_t> da_t;
+    typedef ArrayView<T, hc_t> ha_t;
+
+    ha_t host_array(hc_t().allocate(N));
+    ha_t host_result(hc_t().allocate(N));
+    da_t device_array(dc_t().allocate(N));
+
+    for(auto i: Range(0,N))
+        host_array[i] = T(i);
+    hc_t().set(host_result, 0);
+
+    EmulatedStream stream(true);
+    EXPECT_FALSE(stream.is_default_stream());
+    EXPECT_TRUE(EmulatedStream().is_default_stream());
+
+    auto saved = emulation_settings();
+    emulation_settings().latency = 0.01;
+
+    auto start = stream.insert_event();
+    dc_t().copy_async(host_array, device_array, stream);
+    auto to_host = dc_t().copy_async(device_array, host_result, stream);
+    EXPECT_EQ(kEventBusy, to_host.first.query());
+
+    to_host.first.wait();
+    EXPECT_EQ(kEventReady, to_host.first.query());
+    for(auto i: Range(0,N))
+        EXPECT_EQ(host_array[i], host_result[i]);
+
+    // two transfers, each with 10 ms of latency
+    EXPECT_GE(to_host.first.time_since(start), 0.02);
+
+    emulation_settings() = saved;
+
+    // an event that was never inserted is ready
+    EmulatedEvent e;
+    EXPECT_EQ(kEventReady, e.query());
+    EXPECT_FALSE(std::isnan(e.time_since(to_host.first)));
+
+    hc_t().free(host_array);
+    hc_t().free(host_result);
+    dc_t().free(device_array);
+}
+
+// test that a stream waits on an event in another stream
+TEST(EmulatedDeviceCoordinator, wait_on_event) {
+    using namespace memory;
+
+    EmulatedStream first(true);
+    EmulatedStream second(true);
+
+    int value = 0;
+    first.enqueue([&value] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        value = 1;
+    });
+    auto e = first.insert_event();
+    second.wait_on_event(e);
+
+    int seen = -1;
+    second.enqueue([&value, &seen] {seen = value;});
+    second.synchronize();
+    EXPECT_EQ(1, seen);
+}
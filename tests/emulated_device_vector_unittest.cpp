@@ -0,0 +1,79 @@
+#include "gtest.h"
+
+#include <Vector.hpp>
+#include <HostCoordinator.hpp>
+#include <EmulatedDeviceCoordinator.hpp>
+
+// test that constructors work
+TEST(EmulatedDeviceVector, constructor) {
+    using namespace memory;
+
+    // default constructor
+    EmulatedDeviceVector<float> v0;
+
+    // length constructor
+    const size_t N = 10;
+    EmulatedDeviceVector<float> v1(N);
+    EXPECT_EQ(N, v1.size());
+
+    // copy constructor
+    EmulatedDeviceVector<float> v2(v1);
+    EXPECT_EQ(N, v2.size());
+
+    // range constructor
+    Range r(0,N/2);
+    EmulatedDeviceVector<float> v3(v1(r));
+    EXPECT_EQ(r.size(), v3.size());
+}
+
+TEST(EmulatedDeviceVector, indexing) {
+    using namespace memory;
+
+    const size_t N = 10;
+    EmulatedDeviceVector<float> v1(N);
+
+    for(auto i=0u; i<N; ++i)
+        v1[i] = i;
+
+    for(auto i=0u; i<N; ++i)
+        EXPECT_EQ(float(v1[i]), (float)i);
+}
+
+TEST(EmulatedDeviceVector, fill) {
+    using namespace memory;
+
+    const size_t N = 10;
+
+    {
+        EmulatedDeviceVector<char> v(N);
+        v(memory::all) = 'a';
+        for(auto i=0u; i<N; ++i)
+            EXPECT_EQ(char(v[i]), 'a');
+    }
+    {
+        EmulatedDeviceVector<double> v(N);
+        v(memory::all) = -2.;
+        for(auto i=0u; i<N; ++i)
+            EXPECT_EQ(double(v[i]), -2.);
+    }
+}
+
+// test round trips between host and device vectors
+TEST(EmulatedDeviceVector, host_device_copy) {
+    using namespace memory;
+
+    const size_t N = 100;
+    HostVector<int> h(N);
+    for(auto i=0u; i<N; ++i)
+        h[i] = i;
+
+    EmulatedDeviceVector<int> d(h);
+    HostVector<int> r(d);
+    for(auto i=0u; i<N; ++i)
+        EXPECT_EQ(int(i), r[i]);
+
+    r(memory::all) = 0;
+    r(memory::all) = d;
+    for(auto i=0u; i<N; ++i)
+        EXPECT_EQ(int(i), r[i]);
+}
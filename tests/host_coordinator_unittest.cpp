@@ -1,5 +1,10 @@
 #include "gtest.h"
 
+#include <cstdint>
+#include <map>
+#include <thread>
+
+#include <ArrayGroup.hpp>
 #include <HostCoordinator.hpp>
 
 // helper function for outputting a range
@@ -128,3 +133,183 @@ TEST(HostCoordinator, alignment) {
       HostCoordinator<double, AlignedAllocator<double,512>>::alignment() == 512,
       "bad alignment reported by Host Allocator");
 }
+
+// test that arrays allocated as a group start at different page offsets
+TEST(HostCoordinator, allocate_group) {
+    using namespace memory;
+
+    using coord_t = HostCoordinator<double, AlignedAllocator<double, 32>>;
+    coord_t coordinator;
+
+    const size_t n = 1024; // 8 KiB per array
+    auto group = coordinator.allocate_group(n, 3);
+    EXPECT_EQ(3u, group.size());
+
+    auto offset = [] (double const* p) {
+        return reinterpret_cast<std::uintptr_t>(p)%4096;
+    };
+    for(auto i=0u; i<3u; ++i) {
+        EXPECT_EQ(n, group[i].size());
+        EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(group[i].data())%32);
+        EXPECT_EQ((offset(group[0].data())+64*i)%4096, offset(group[i].data()));
+        coordinator.set(group[i], double(i));
+    }
+
+    // the arrays don't overlap
+    EXPECT_FALSE(group[0].overlaps(group[1]));
+    EXPECT_FALSE(group[1].overlaps(group[2]));
+    for(auto i=0u; i<3u; ++i)
+        EXPECT_EQ(double(i), group[i][n-1]);
+
+    // offsets are rounded up to the alignment
+    auto coarse = coordinator.allocate_group(10, 2, 8);
+    EXPECT_EQ(32u, (offset(coarse[1].data())-offset(coarse[0].data()))%4096);
+
+    coordinator.free_group(group);
+    coordinator.free_group(coarse);
+    EXPECT_TRUE(group.empty());
+}
+
+namespace {
+    // an allocator that checks that memory is freed with the size with
+    // which it was allocated
+    template <typename T>
+    class SizeCheckingAllocator:
+        public memory::Allocator<T, memory::impl::AlignedPolicy<32>>
+    {
+        using base = memory::Allocator<T, memory::impl::AlignedPolicy<32>>;
+    public:
+        template <typename U>
+        using rebind = SizeCheckingAllocator<U>;
+
+        static std::map<void*, std::size_t>& sizes() {
+            static std::map<void*, std::size_t> s;
+            return s;
+        }
+
+        T* allocate(std::size_t n) {
+            auto p = base::allocate(n);
+            sizes()[p] = n;
+            return p;
+        }
+
+        void deallocate(T* p, std::size_t n) {
+            EXPECT_EQ(sizes()[p], n);
+            sizes().erase(p);
+            base::deallocate(p, n);
+        }
+    };
+}
+
+// test that freeing a group frees the whole block that was allocated
+TEST(HostCoordinator, free_group) {
+    using namespace memory;
+
+    using alloc_t = SizeCheckingAllocator<double>;
+    HostCoordinator<double, alloc_t> coordinator;
+
+    for(auto count: {1u, 2u, 5u}) {
+        auto group = coordinator.allocate_group(100, count);
+        EXPECT_EQ(1u, alloc_t::sizes().size());
+        coordinator.free_group(group);
+        EXPECT_TRUE(alloc_t::sizes().empty());
+    }
+}
+
+// test that groups own their memory
+TEST(HostCoordinator, array_group) {
+    using namespace memory;
+
+    ArrayGroup<float> arrays(100, 4, 128);
+    EXPECT_EQ(4u, arrays.size());
+    for(auto i=0u; i<4u; ++i) {
+        EXPECT_EQ(100u, arrays[i].size());
+        arrays[i](all) = float(i);
+    }
+    EXPECT_EQ(3.f, arrays[3][99]);
+    EXPECT_EQ(128u,
+        (reinterpret_cast<std::uintptr_t>(arrays[1].data())
+        - reinterpret_cast<std::uintptr_t>(arrays[0].data()))%4096);
+}
+
+// test copy and fill with the transfer split across a thread team
+TEST(HostCoordinator, parallel_transfer) {
+    using namespace memory;
+
+    auto saved = threading::transfer_settings();
+    threading::transfer_settings().num_threads = 4;
+    threading::transfer_settings().parallel_threshold = 1024;
+
+    typedef HostCoordinator<int> intcoord_t;
+    intcoord_t coordinator;
+
+    // a transfer large enough to be split
+    const size_t n = 10000;
+    auto a = coordinator.allocate(n);
+    auto b = coordinator.allocate(n);
+    coordinator.set(a, 3);
+    for(auto i: a.range())
+        a[i] += int(i);
+    coordinator.copy(a, b);
+    for(auto i: b.range())
+        EXPECT_EQ(int(i)+3, b[i]);
+
+    // a transfer below the threshold
+    auto c = coordinator.allocate(10);
+    coordinator.set(c, 7);
+    for(auto v: c)
+        EXPECT_EQ(7, v);
+
+    coordinator.free(a);
+    coordinator.free(b);
+    coordinator.free(c);
+    threading::transfer_settings() = saved;
+}
+
+// test asynchronous copy and fill, which are split over the threads of
+// threading::async_pool(), however many threads it was started with
+TEST(HostCoordinator, async_transfer) {
+    using namespace memory;
+
+    typedef HostCoordinator<int> intcoord_t;
+    intcoord_t coordinator;
+
+    const size_t n = 10000;
+    auto a = coordinator.allocate(n);
+    auto b = coordinator.allocate(n);
+
+    auto fill = coordinator.set_async(a, 5);
+    fill.wait();
+    EXPECT_EQ(kEventReady, fill.query());
+    for(auto v: a)
+        EXPECT_EQ(5, v);
+
+    for(auto i: a.range())
+        a[i] += int(i);
+    auto copy = coordinator.copy_async(a, b);
+    copy.wait();
+    EXPECT_EQ(kEventReady, copy.query());
+    for(auto i: b.range())
+        EXPECT_EQ(int(i)+5, b[i]);
+
+    // an empty transfer is ready immediately
+    auto empty = coordinator.allocate(0);
+    EXPECT_EQ(kEventReady, coordinator.set_async(empty, 1).query());
+
+    coordinator.free(a);
+    coordinator.free(b);
+}
+
+TEST(HostCoordinator, host_event) {
+    using namespace memory;
+
+    HostEvent event(2);
+    HostEvent copy = event;
+    EXPECT_EQ(kEventBusy, event.query());
+    copy.signal();
+    EXPECT_EQ(kEventBusy, event.query());
+    std::thread t([copy]() mutable {copy.signal();});
+    event.wait();
+    EXPECT_EQ(kEventReady, event.query());
+    t.join();
+}
@@ -1,6 +1,8 @@
 #include "gtest.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <numeric>
 #include <vector>
 
 #include <Vector.hpp>
@@ -167,3 +169,112 @@ TEST(HostVector, from_std_vector) {
         EXPECT_EQ(v[i], hv[i]);
     }
 }
+
+// test that a pooled allocator can be used as a drop in replacement
+TEST(HostVector, pool_allocator) {
+    using namespace memory;
+    using vector = Array<double, HostCoordinator<double, PoolAllocator<double, 64>>>;
+
+    double* first;
+    {
+        vector v(1000, 1.);
+        first = v.data();
+        EXPECT_EQ(1000u, v.size());
+    }
+    // the temporary in the next scope recycles the memory of the first
+    for(auto i=0; i<10; ++i) {
+        vector v(1000, 2.);
+        EXPECT_EQ(first, v.data());
+        for(auto val: v)
+            EXPECT_EQ(2., val);
+    }
+}
+
+// test that huge page vectors report the pages that back them
+TEST(HostVector, huge_page_vector) {
+    using namespace memory;
+
+    // small vectors are not backed by huge pages
+    HugePageVector<double> small(100, 1.);
+    EXPECT_EQ(kPageSmall, page_backing(small));
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(small.data())%64);
+
+    // large vectors are 2 MiB aligned, whichever backing was obtained
+    const size_t n = (size_t(4)<<20)/sizeof(double);
+    HugePageVector<double> large(n, 2.);
+    auto backing = page_backing(large);
+    EXPECT_TRUE(backing==kPageSmall ||
+                backing==kPageTransparentHuge ||
+                backing==kPageHugeTLB);
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(large.data())%(size_t(1)<<21));
+    for(auto i: {size_t(0), n/2, n-1})
+        EXPECT_EQ(2., large[i]);
+}
+
+// test that first-touch construction initializes every chunk
+TEST(HostVector, first_touch_constructor) {
+    using namespace memory;
+
+    const size_t n = 1000;
+    SplitRange split(Range(0, n), 7);
+
+    HostVector<double> v1(n, 3., split);
+    EXPECT_EQ(n, v1.size());
+    for(auto value: v1)
+        EXPECT_EQ(3., value);
+
+    HostVector<int> v2(n, split);
+    EXPECT_EQ(n, v2.size());
+    for(auto value: v2)
+        EXPECT_EQ(0, value);
+}
+
+// test the tagged constructors
+TEST(HostVector, tagged_constructors) {
+    using namespace memory;
+
+    HostVector<double> v1(100, uninitialized);
+    EXPECT_EQ(100u, v1.size());
+    EXPECT_NE(nullptr, v1.data());
+
+    HostVector<double> v2(1000, 3., parallel_fill);
+    EXPECT_EQ(1000u, v2.size());
+    for(auto value: v2)
+        EXPECT_EQ(3., value);
+
+    HostVector<int> v3(10, 4, parallel_fill, 16);
+    EXPECT_EQ(10u, v3.size());
+    for(auto value: v3)
+        EXPECT_EQ(4, value);
+
+    HostVector<int> v4(0, 4, parallel_fill);
+    EXPECT_EQ(0u, v4.size());
+}
+
+// test that padded vectors expose a zeroed pad
+TEST(HostVector, padded_vector) {
+    using namespace memory;
+
+    // 64 byte padding is 8 doubles
+    PaddedVector<double> v(13, 1.);
+    EXPECT_EQ(13u, v.size());
+    EXPECT_EQ(16u, v.padded_size());
+    auto padded = v.padded_view();
+    EXPECT_EQ(16u, padded.size());
+    EXPECT_EQ(v.data(), padded.data());
+    for(auto i=13u; i<16u; ++i)
+        EXPECT_EQ(0., padded[i]);
+
+    // sizes that are a multiple of the padding width have no pad
+    PaddedVector<float> w(32);
+    EXPECT_EQ(32u, w.padded_size());
+
+    // copies are padded too
+    PaddedVector<double> c(v);
+    EXPECT_EQ(16u, c.padded_size());
+    EXPECT_EQ(0., c.padded_view()[15]);
+
+    // unpadded vectors report their size
+    HostVector<double> h(13);
+    EXPECT_EQ(13u, h.padded_size());
+}
@@ -0,0 +1,77 @@
+#include "gtest.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <string>
+
+#include <unistd.h>
+
+#include <MappedFile.hpp>
+#include <Vector.hpp>
+
+// test arrays backed by anonymous temporary files
+TEST(MappedFile, temporary_file_policy) {
+    using namespace memory;
+
+    MappedVector<double> v(1000, 2.);
+    EXPECT_EQ(1000u, v.size());
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(v.data())%4096);
+    for(auto value: v)
+        EXPECT_EQ(2., value);
+
+    // copy to and from host vectors
+    HostVector<double> h(v);
+    h(all) = 3.;
+    v(0, 10) = h(0, 10);
+    EXPECT_EQ(3., v[0]);
+    EXPECT_EQ(3., v[9]);
+    EXPECT_EQ(2., v[10]);
+
+    // the access pattern flags are accepted
+    using flagged = Array<int, HostCoordinator<int,
+        MappedFileAllocator<int, kMapPopulate|kMapSequential|kMapWillNeed>>>;
+    flagged f(100, 7);
+    EXPECT_EQ(7, f[99]);
+}
+
+// test that data written to a named file can be mapped again
+TEST(MappedFile, named_file) {
+    using namespace memory;
+
+    auto path = std::string("/tmp/vector_mapped_file_test.")
+              + std::to_string(getpid());
+    std::remove(path.c_str());
+
+    {
+        MappedFile<int> file(path, 100);
+        EXPECT_TRUE(file.is_open());
+        EXPECT_EQ(100u, file.size());
+
+        auto view = file.view();
+        std::iota(view.begin(), view.end(), 0);
+        EXPECT_TRUE(file.sync());
+    }
+
+    {
+        // the size is taken from the file
+        MappedFile<int, kMapWillNeed> file(path);
+        EXPECT_TRUE(file.is_open());
+        EXPECT_EQ(100u, file.size());
+
+        auto view = file.view();
+        for(auto i: view.range())
+            EXPECT_EQ(int(i), view[i]);
+
+        // views can be copied into other memory spaces
+        HostVector<int> copy(view);
+        EXPECT_EQ(99, copy[99]);
+    }
+
+    std::remove(path.c_str());
+
+    // failing to open a file leaves an empty mapping
+    MappedFile<int> missing("/nonexistent/path/file", 10);
+    EXPECT_FALSE(missing.is_open());
+    EXPECT_EQ(0u, missing.size());
+}
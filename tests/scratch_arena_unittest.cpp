@@ -0,0 +1,92 @@
+#include "gtest.h"
+
+#include <cstdint>
+
+#include <Array.hpp>
+#include <HostCoordinator.hpp>
+#include <ScratchArena.hpp>
+
+template <typename T>
+using scratch_vector =
+    memory::Array<T, memory::HostCoordinator<T, memory::ArenaAllocator<T, 64>>>;
+
+// test bump pointer allocation and alignment
+TEST(ScratchArena, allocate) {
+    using namespace memory;
+
+    ScratchArena arena(1024);
+    EXPECT_EQ(1024u, arena.capacity());
+    EXPECT_EQ(0u, arena.used());
+
+    auto p1 = arena.allocate(10, 8);
+    auto p2 = arena.allocate(10, 64);
+    EXPECT_NE(nullptr, p1);
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(p1)%8);
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(p2)%64);
+    EXPECT_EQ(64u+10u, arena.used());
+
+    // allocation fails when the arena is exhausted
+    EXPECT_EQ(nullptr, arena.allocate(1024, 8));
+    EXPECT_EQ(64u+10u, arena.used());
+}
+
+// test that scopes release memory and track the high water mark
+TEST(ScratchArena, scopes) {
+    using namespace memory;
+
+    ScratchArena arena(1<<16);
+    EXPECT_EQ(nullptr, ScratchArena::current());
+    {
+        ScratchArena::Scope outer(arena);
+        EXPECT_EQ(&arena, ScratchArena::current());
+
+        scratch_vector<double> a(128, 1.);
+        auto used = arena.used();
+        EXPECT_EQ(1024u, used);
+        {
+            ScratchArena::Scope inner(arena);
+            scratch_vector<double> b(128, 2.);
+            scratch_vector<double> c(b);
+
+            // temporaries are packed next to each other
+            EXPECT_EQ(a.data()+128, b.data());
+            EXPECT_EQ(b.data()+128, c.data());
+            EXPECT_EQ(2., c[127]);
+            EXPECT_EQ(3072u, arena.used());
+        }
+        EXPECT_EQ(used, arena.used());
+
+        // memory released by the inner scope is reused
+        scratch_vector<double> d(10);
+        EXPECT_EQ(a.data()+128, d.data());
+        EXPECT_EQ(1., a[127]);
+    }
+    EXPECT_EQ(0u, arena.used());
+    EXPECT_EQ(3072u, arena.high_water_mark());
+    EXPECT_EQ(nullptr, ScratchArena::current());
+
+    arena.reset_high_water_mark();
+    EXPECT_EQ(0u, arena.high_water_mark());
+}
+
+// an allocator constructed with an arena allocates from it on any thread,
+// without a Scope
+TEST(ScratchArena, explicit_arena) {
+    using namespace memory;
+
+    using alloc_t = ArenaAllocator<double>;
+    using coord_t = HostCoordinator<double, alloc_t>;
+
+    ScratchArena arena(1<<16);
+    coord_t coord{alloc_t(arena)};
+    EXPECT_EQ(nullptr, ScratchArena::current());
+
+    Array<double, coord_t> a(100, 1., coord);
+    EXPECT_EQ(100*sizeof(double), arena.used());
+    EXPECT_EQ(1., a[99]);
+
+    // copies share the arena
+    auto b = a;
+    EXPECT_EQ(200*sizeof(double), arena.used());
+    EXPECT_EQ(1., b[0]);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Range.hpp>
+
+#include "gtest.h"
+
+// Checks shared by the tests of the ways of splitting a range.
+namespace memory_test {
+    // check that the chunks of split are contiguous and cover rng
+    // split can be any iterable set of ranges
+    template <typename Split>
+    void check_cover(Split const& split, memory::Range rng) {
+        auto first = rng.left();
+        for(auto r: split) {
+            EXPECT_EQ(first, r.left());
+            first = r.right();
+        }
+        EXPECT_EQ(rng.right(), first);
+    }
+} // namespace memory_test
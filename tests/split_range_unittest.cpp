@@ -31,3 +31,94 @@ TEST(SplitRange, split) {
     for(int i=0; i<num_splits; ++i)
         EXPECT_EQ(splits[i].size(), ranges[i].size());
 }
+
+// the default mode makes chunks of ceil(size/n), and can make fewer than n
+TEST(SplitRange, step) {
+    using namespace memory;
+
+    SplitRange split(Range(0, 10), 4);
+    EXPECT_EQ(kSplitStep, split.mode());
+    EXPECT_EQ(4u, split.size());
+    EXPECT_EQ(3u, split.step_size());
+    EXPECT_EQ(Range(9, 10), split[3]);
+
+    SplitRange fewer(Range(0, 10), 6);
+    EXPECT_EQ(5u, fewer.size());
+    EXPECT_EQ(5, std::distance(fewer.begin(), fewer.end()));
+
+    EXPECT_EQ(0u, SplitRange(Range(4, 4), 3).size());
+}
+
+TEST(SplitRange, balanced) {
+    using namespace memory;
+
+    SplitRange split(Range(0, 10), 4, kSplitBalanced);
+    std::vector<Range> expected = {{0, 3}, {3, 6}, {6, 8}, {8, 10}};
+    EXPECT_EQ(expected, std::vector<Range>(split.begin(), split.end()));
+    EXPECT_EQ(3u, split.step_size());
+
+    // n chunks of at least one value, that differ in size by at most one
+    for(auto n: {1u, 3u, 7u, 13u, 100u, 101u, 200u}) {
+        SplitRange s(Range(5, 105), n, kSplitBalanced);
+        EXPECT_EQ(std::min(n, 100u), s.size());
+
+        auto first = 5u;
+        std::size_t smallest = 100, largest = 0;
+        for(auto r: s) {
+            EXPECT_EQ(first, r.left());
+            first = r.right();
+            smallest = std::min(smallest, r.size());
+            largest = std::max(largest, r.size());
+        }
+        EXPECT_EQ(105u, first);
+        EXPECT_LE(largest-smallest, 1u);
+        EXPECT_LE(1u, smallest);
+    }
+}
+
+// every boundary between chunks is a multiple of the granularity
+TEST(SplitRange, aligned) {
+    using namespace memory;
+
+    for(auto n: {1u, 2u, 3u, 8u, 50u}) {
+        SplitRange s(Range(3, 1003), n, kSplitAligned, 16);
+        EXPECT_EQ(kSplitAligned, s.mode());
+        EXPECT_EQ(16u, s.granularity());
+        EXPECT_LE(s.size(), n);
+        EXPECT_EQ(3u, s.begin()->left());
+        EXPECT_EQ(1003u, s[s.size()-1].right());
+
+        for(auto i=1u; i<s.size(); ++i) {
+            EXPECT_EQ(s[i-1].right(), s[i].left());
+            EXPECT_EQ(0u, s[i].left()%16);
+            EXPECT_LT(0u, s[i].size());
+        }
+    }
+
+    // a range that fits in fewer blocks than chunks requested
+    EXPECT_EQ(2u, SplitRange(Range(10, 20), 8, kSplitAligned, 16).size());
+
+    // 8 doubles, or 16 floats, fill a 64 byte cache line
+    EXPECT_EQ(8u, aligned_split<double>(Range(0, 1000), 4).granularity());
+    EXPECT_EQ(16u, aligned_split<float>(Range(0, 1000), 4).granularity());
+    // 8 values of 24 bytes fill 3 cache lines
+    struct three_words {double x, y, z;};
+    EXPECT_EQ(8u, aligned_split<three_words>(Range(0, 1000), 4).granularity());
+}
+
+// the iterator supports random access
+TEST(SplitRange, iterator) {
+    using namespace memory;
+
+    SplitRange split(Range(0, 100), 7, kSplitBalanced);
+    auto it = split.begin();
+    EXPECT_EQ(split[3], *(it+3));
+    EXPECT_EQ(split[4], it[4]);
+    it += 6;
+    EXPECT_EQ(split[6], *it);
+    --it;
+    EXPECT_EQ(split[5], *it);
+    EXPECT_EQ(7, split.end()-split.begin());
+    EXPECT_TRUE(split.begin()<split.end());
+    EXPECT_EQ(Range(100, 100), *split.end());
+}
@@ -0,0 +1,66 @@
+#include "gtest.h"
+
+#include <EmulatedDeviceCoordinator.hpp>
+#include <StagedCopy.hpp>
+#include <Vector.hpp>
+
+// copy between host allocators with chunks that do not divide the array,
+// for different numbers of buffers
+TEST(StagedCopy, host_to_host) {
+    using namespace memory;
+
+    using pool_vector = Array<int, HostCoordinator<int, PoolAllocator<int>>>;
+
+    const size_t n = 1000;
+    HostVector<int> from(n);
+    for(auto i=0u; i<n; ++i)
+        from[i] = i;
+
+    for(auto n_buffers: {1u, 2u, 3u, 8u}) {
+        for(auto chunk_bytes: {size_t(1), size_t(4*7), size_t(4*n), size_t(1<<20)}) {
+            pool_vector to(n, -1);
+            staged_copy(from, to, chunk_bytes, n_buffers);
+            for(auto i=0u; i<n; ++i)
+                EXPECT_EQ(int(i), to[i]);
+        }
+    }
+
+    // sub-ranges and empty ranges
+    pool_vector to(n, -1);
+    staged_copy(from(0, 10), to(100, 110), 8, 2);
+    staged_copy(from(0, 0), to(0, 0), 8, 2);
+    for(auto i=0u; i<n; ++i)
+        EXPECT_EQ(i>=100 && i<110 ? int(i-100) : -1, to[i]);
+}
+
+TEST(StagedCopy, mapped_to_host) {
+    using namespace memory;
+
+    const size_t n = 5000;
+    MappedVector<double> from(n);
+    for(auto i=0u; i<n; ++i)
+        from[i] = 0.5*i;
+
+    HostVector<double> to(n, 0.);
+    staged_copy(from, to, 1024, 3);
+    for(auto i=0u; i<n; ++i)
+        EXPECT_EQ(0.5*i, to[i]);
+}
+
+// copy to and from an emulated device through host staging buffers
+TEST(StagedCopy, emulated_device) {
+    using namespace memory;
+
+    const size_t n = 1000;
+    HostVector<float> from(n);
+    for(auto i=0u; i<n; ++i)
+        from[i] = i;
+
+    EmulatedDeviceVector<float> device(n);
+    staged_copy(from, device, 256, 2);
+
+    HostVector<float> to(n, -1.f);
+    staged_copy(device, to, 256, 2);
+    for(auto i=0u; i<n; ++i)
+        EXPECT_EQ(float(i), to[i]);
+}
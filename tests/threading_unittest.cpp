@@ -0,0 +1,145 @@
+#include "gtest.h"
+
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <SplitRange.hpp>
+#include <Threading.hpp>
+
+// test that every chunk is visited once, by a team of at most one thread
+// per hardware thread that includes the calling thread
+TEST(Threading, for_each_chunk) {
+    using namespace memory;
+
+    const size_t n = 100;
+    const size_t num_chunks = 6;
+    SplitRange split(Range(0, n), num_chunks);
+
+    std::mutex mutex;
+    std::vector<int> counts(n, 0);
+    std::set<std::thread::id> ids;
+    std::vector<Range> chunks(num_chunks);
+
+    threading::for_each_chunk(split,
+        [&] (size_t i, Range r) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ids.insert(std::this_thread::get_id());
+            chunks[i] = r;
+            for(auto j: r)
+                counts[j]++;
+        });
+
+    EXPECT_EQ(std::min<size_t>(num_chunks, threading::hardware_threads()), ids.size());
+    EXPECT_EQ(1u, ids.count(std::this_thread::get_id()));
+    for(auto i=0u; i<num_chunks; ++i)
+        EXPECT_EQ(split[i], chunks[i]);
+    for(auto c: counts)
+        EXPECT_EQ(1, c);
+}
+
+// test that first touch visits every chunk once, on threads bound to one
+// of the cpus of the caller each
+TEST(Threading, first_touch) {
+    using namespace memory;
+
+    const size_t n = 1000;
+    const size_t num_chunks = 13;
+    SplitRange split(Range(0, n), num_chunks);
+
+    std::mutex mutex;
+    std::vector<int> counts(n, 0);
+    std::set<std::thread::id> ids;
+    std::vector<Range> chunks(num_chunks);
+    bool bound = true;
+
+    threading::first_touch(split,
+        [&] (size_t i, Range r) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ids.insert(std::this_thread::get_id());
+            chunks[i] = r;
+            for(auto j: r)
+                counts[j]++;
+            #if defined(__linux__) && !defined(_OPENMP)
+            cpu_set_t set;
+            sched_getaffinity(0, sizeof(set), &set);
+            bound = bound && CPU_COUNT(&set)==1;
+            #endif
+        });
+
+    auto cpus = threading::impl::allowed_cpus().size();
+    EXPECT_LE(ids.size(), std::min(num_chunks, cpus ? cpus : num_chunks));
+    EXPECT_TRUE(bound);
+    for(auto i=0u; i<num_chunks; ++i)
+        EXPECT_EQ(split[i], chunks[i]);
+    for(auto c: counts)
+        EXPECT_EQ(1, c);
+
+    // the binding of the calling thread is unchanged
+    EXPECT_EQ(cpus, threading::impl::allowed_cpus().size());
+}
+
+// test that first touch does nothing for an empty split, and that a small
+// team is spread over the cpus of the caller
+TEST(Threading, first_touch_spread) {
+    using namespace memory;
+
+    auto calls = 0;
+    threading::first_touch(std::vector<Range>(),
+        [&] (size_t, Range) {
+            ++calls;
+        });
+    EXPECT_EQ(0, calls);
+
+    #if defined(__linux__) && !defined(_OPENMP)
+    auto cpus = threading::impl::allowed_cpus();
+    if(cpus.size()<2) {
+        return;
+    }
+
+    std::mutex mutex;
+    std::vector<int> bound_to(2, -1);
+    threading::first_touch(SplitRange(Range(0, 100), 2),
+        [&] (size_t i, Range) {
+            cpu_set_t set;
+            sched_getaffinity(0, sizeof(set), &set);
+            std::lock_guard<std::mutex> lock(mutex);
+            for(auto cpu: cpus) {
+                if(CPU_ISSET(cpu, &set)) {
+                    bound_to[i] = cpu;
+                }
+            }
+        });
+
+    EXPECT_EQ(cpus[0], bound_to[0]);
+    EXPECT_EQ(cpus[cpus.size()/2], bound_to[1]);
+    #endif
+}
+
+// test that a pool runs every task on its own threads, and runs the tasks
+// still queued when it is destroyed
+TEST(Threading, thread_pool) {
+    using namespace memory;
+
+    const auto num_tasks = 100;
+    std::mutex mutex;
+    std::set<std::thread::id> ids;
+    auto count = 0;
+    {
+        threading::ThreadPool pool(3);
+        EXPECT_EQ(3u, pool.size());
+        for(auto i=0; i<num_tasks; ++i) {
+            pool.enqueue([&] {
+                std::lock_guard<std::mutex> lock(mutex);
+                ids.insert(std::this_thread::get_id());
+                ++count;
+            });
+        }
+    }
+
+    EXPECT_EQ(num_tasks, count);
+    EXPECT_LE(ids.size(), 3u);
+    EXPECT_EQ(0u, ids.count(std::this_thread::get_id()));
+}
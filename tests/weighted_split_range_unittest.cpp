@@ -0,0 +1,116 @@
+#include "gtest.h"
+#include "split_checks.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <Vector.hpp>
+#include <WeightedSplitRange.hpp>
+
+namespace {
+    // the largest total cost of a chunk of split
+    template <typename Split, typename Costs>
+    double max_cost(Split const& split, Costs const& costs) {
+        double largest = 0;
+        for(auto r: split) {
+            double sum = 0;
+            for(auto i: r) {
+                sum += costs[i];
+            }
+            largest = std::max(largest, sum);
+        }
+        return largest;
+    }
+}
+
+using memory_test::check_cover;
+
+// uniform costs give chunks of similar size
+TEST(WeightedSplitRange, uniform) {
+    using namespace memory;
+
+    HostVector<double> costs(100, 1.);
+    WeightedSplitRange split(Range(0, 100), 4, costs);
+
+    EXPECT_EQ(4u, split.size());
+    check_cover(split, Range(0, 100));
+    for(auto r: split) {
+        EXPECT_EQ(25u, r.size());
+    }
+    EXPECT_EQ(split[2], split(2));
+}
+
+// uneven costs give chunks of similar cost
+TEST(WeightedSplitRange, uneven) {
+    using namespace memory;
+
+    // the second half of the range costs ten times the first
+    const auto n = 1000u;
+    HostVector<double> costs(n);
+    for(auto i: Range(0, n)) {
+        costs[i] = i<n/2 ? 1. : 10.;
+    }
+
+    const auto num_chunks = 8u;
+    WeightedSplitRange weighted(Range(0, n), num_chunks, costs);
+    SplitRange even(Range(0, n), num_chunks);
+
+    EXPECT_EQ(num_chunks, weighted.size());
+    check_cover(weighted, Range(0, n));
+
+    // the total cost is 5500, so the ideal chunk costs 687.5
+    auto ideal = 5500./num_chunks;
+    EXPECT_LE(max_cost(weighted, costs), ideal+10.);
+    EXPECT_GT(max_cost(even, costs), 1.4*ideal);
+
+    // a sub-range is split using the costs of its elements
+    WeightedSplitRange sub(Range(400, 600), 2, costs);
+    check_cover(sub, Range(400, 600));
+    // 100 elements of cost 1 and 45 of cost 10 make half of 1100
+    EXPECT_EQ(Range(400, 545), sub[0]);
+}
+
+// the parallel prefix sum gives the same chunks as the serial one
+TEST(WeightedSplitRange, parallel) {
+    using namespace memory;
+
+    const auto n = 10000u;
+    HostVector<float> costs(n);
+    for(auto i: Range(0, n)) {
+        costs[i] = float(i%7);
+    }
+
+    WeightedSplitRange serial(Range(0, n), 6, costs);
+
+    auto saved = threading::transfer_settings();
+    threading::transfer_settings().num_threads = 4;
+    threading::transfer_settings().parallel_threshold = 0;
+    WeightedSplitRange parallel(Range(0, n), 6, costs);
+    threading::transfer_settings() = saved;
+
+    EXPECT_TRUE(std::equal(serial.begin(), serial.end(), parallel.begin()));
+}
+
+// there are always n chunks, which can be empty
+TEST(WeightedSplitRange, empty_chunks) {
+    using namespace memory;
+
+    // one element has all of the cost
+    HostVector<int> costs(10, 0);
+    costs[5] = 1;
+    WeightedSplitRange heavy(Range(0, 10), 4, costs);
+    EXPECT_EQ(4u, heavy.size());
+    check_cover(heavy, Range(0, 10));
+
+    // zero cost gives balanced chunks
+    HostVector<int> zero(10, 0);
+    WeightedSplitRange balanced(Range(0, 10), 4, zero);
+    std::vector<Range> expected = {{0, 3}, {3, 6}, {6, 8}, {8, 10}};
+    EXPECT_EQ(expected, std::vector<Range>(balanced.begin(), balanced.end()));
+
+    // more chunks than elements
+    WeightedSplitRange many(Range(0, 3), 5, zero);
+    EXPECT_EQ(5u, many.size());
+    check_cover(many, Range(0, 3));
+    EXPECT_EQ(0u, many[4].size());
+}
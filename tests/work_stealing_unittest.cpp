@@ -0,0 +1,140 @@
+#include "gtest.h"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <Range.hpp>
+#include <WorkStealing.hpp>
+
+// splitting a range keeps the left half and returns the right half
+TEST(WorkStealing, range_split) {
+    using namespace memory;
+
+    Range r(3, 10);
+    EXPECT_TRUE(r.is_divisible());
+    auto right = r.split();
+    EXPECT_EQ(Range(3, 6), r);
+    EXPECT_EQ(Range(6, 10), right);
+
+    Range one(4, 5);
+    EXPECT_FALSE(one.is_divisible());
+    EXPECT_FALSE(one.empty());
+    EXPECT_TRUE(Range(4, 4).empty());
+}
+
+// every value is visited once, in sub-ranges of at most grain values
+TEST(WorkStealing, parallel_for) {
+    using namespace memory;
+
+    threading::WorkStealingPool pool(3);
+    EXPECT_EQ(3u, pool.size());
+
+    const auto n = 100000u;
+    const auto grain = 1000u;
+    std::vector<int> counts(n, 0);
+    std::mutex mutex;
+    std::set<std::thread::id> ids;
+
+    threading::parallel_for(pool, Range(0, n), grain,
+        [&](Range r) {
+            EXPECT_LE(r.size(), grain);
+            EXPECT_LT(grain/2, r.size());
+            for(auto i: r) {
+                counts[i]++;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            ids.insert(std::this_thread::get_id());
+        });
+
+    for(auto c: counts) {
+        EXPECT_EQ(1, c);
+    }
+    EXPECT_LE(ids.size(), 4u);
+
+    // empty ranges and ranges smaller than the grain
+    auto calls = 0;
+    threading::parallel_for(pool, Range(5, 5), grain, [&](Range) {++calls;});
+    EXPECT_EQ(0, calls);
+    threading::parallel_for(pool, Range(5, 6), grain, [&](Range) {++calls;});
+    EXPECT_EQ(1, calls);
+}
+
+// a pool with no background threads runs every task on the waiting thread
+TEST(WorkStealing, serial_pool) {
+    using namespace memory;
+
+    threading::WorkStealingPool pool(0);
+    std::atomic<int> sum(0);
+    std::set<std::thread::id> ids;
+    threading::parallel_for(pool, Range(0, 100), 7,
+        [&](Range r) {
+            ids.insert(std::this_thread::get_id());
+            for(auto i: r) {
+                sum += int(i);
+            }
+        });
+    EXPECT_EQ(4950, sum);
+    EXPECT_EQ(1u, ids.size());
+    EXPECT_EQ(1u, ids.count(std::this_thread::get_id()));
+}
+
+// nested loops run on the threads of the pool, instead of new threads
+TEST(WorkStealing, nested) {
+    using namespace memory;
+
+    threading::WorkStealingPool pool(2);
+
+    const auto n = 64u;
+    std::vector<std::atomic<int>> counts(n*n);
+    for(auto& c: counts) {
+        c = 0;
+    }
+    std::mutex mutex;
+    std::set<std::thread::id> ids;
+
+    threading::parallel_for(pool, Range(0, n), 1,
+        [&](Range outer) {
+            threading::parallel_for(pool, Range(0, n), 4,
+                [&](Range inner) {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        ids.insert(std::this_thread::get_id());
+                    }
+                    for(auto i: outer) {
+                        for(auto j: inner) {
+                            counts[i*n+j]++;
+                        }
+                    }
+                });
+        });
+
+    for(auto& c: counts) {
+        EXPECT_EQ(1, c);
+    }
+    // the two pool threads and the calling thread
+    EXPECT_LE(ids.size(), 3u);
+}
+
+// a recursive kernel that waits on its own task groups
+TEST(WorkStealing, recursive) {
+    using namespace memory;
+
+    threading::WorkStealingPool pool(3);
+
+    std::function<long(long)> fib = [&](long k) -> long {
+        if(k<2) {
+            return k;
+        }
+        long a = 0;
+        threading::TaskGroup group(pool);
+        group.run([&] {a = fib(k-1);});
+        long b = fib(k-2);
+        group.wait();
+        return a+b;
+    };
+
+    EXPECT_EQ(6765, fib(20));
+}